@@ -19,6 +19,32 @@
 #include <cstring>
 #include <array>
 #include <set>
+#include <map>
+#include <bitset>
+#include <memory>
+#include <type_traits>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <queue>
+#include <climits>
+#include <cfloat>
+
+//sse2 is always there on x64, avx only when the compiler is allowed to use it (/arch:AVX or -mavx), the batch kernels fall back to plain loops otherwise
+#if defined(__AVX__)
+#define SIMD_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE 1
+#endif
+#if defined(SIMD_AVX) || defined(SIMD_SSE)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #define NOMINMAX
 
@@ -29,6 +55,7 @@
 #include "tiny_obj_loader.h"
 
 #include <unordered_map>
+#include <unordered_set>
 
 #include <glm/gtx/hash.hpp>
 
@@ -90,9 +117,95 @@ namespace std {
 	};
 }
 
+//one placed primitive for the instanced pipeline, the vertex shader rotates the primitive's model and moves it to position
+struct BlockInstance {
+	glm::ivec3 position;
+	//low 3 bits are the BlockMesher::orientation, the rest is left for block state
+	uint32_t orientation;
+
+	static VkVertexInputBindingDescription getBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = 1;
+		bindingDescription.stride = sizeof(BlockInstance);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+		return bindingDescription;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+		std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
+
+		attributeDescriptions[0].binding = 1;
+		attributeDescriptions[0].location = 3;
+		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SINT;
+		attributeDescriptions[0].offset = offsetof(BlockInstance, position);
+
+		attributeDescriptions[1].binding = 1;
+		attributeDescriptions[1].location = 4;
+		attributeDescriptions[1].format = VK_FORMAT_R32_UINT;
+		attributeDescriptions[1].offset = offsetof(BlockInstance, orientation);
+
+		return attributeDescriptions;
+	}
+};
+
+//compact vertex for chunk geometry, 12 bytes instead of 32
+//the position is relative to the chunk's corner in 1024ths of a block, so models can stick out of the chunk by up to 16 blocks, and the chunk's origin comes in as a push constant
+const float PACKED_POSITION_SCALE = 1024.0f;
+struct PackedVertex {
+	int16_t pos[3];
+	//left for per vertex state, nothing sets it yet
+	uint16_t flags;
+	uint8_t color[4];
+
+	static VkVertexInputBindingDescription getBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(PackedVertex);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	//position and flags are read as one 4 component attribute, 3 component 16 bit formats are often not supported for vertex buffers
+	static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+		std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
+
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SINT;
+		attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+		attributeDescriptions[1].offset = offsetof(PackedVertex, color);
+
+		return attributeDescriptions;
+	}
+
+	//texCoord is dropped, block geometry is never textured, and colours are clamped the way the framebuffer would clamp them
+	static PackedVertex pack(const Vertex& vertex, glm::ivec3 origin) {
+		PackedVertex packed;
+		for (int i = 0; i < 3; i++) {
+			float position = (vertex.pos[i] - origin[i]) * PACKED_POSITION_SCALE;
+			position = std::min(std::max(position, (float)SHRT_MIN), (float)SHRT_MAX);
+			packed.pos[i] = (int16_t)floorf(position + 0.5f);
+			float colour = std::min(std::max(vertex.color[i], 0.0f), 1.0f);
+			packed.color[i] = (uint8_t)(colour * 255.0f + 0.5f);
+		}
+		packed.flags = 0;
+		packed.color[3] = 255;
+		return packed;
+	}
+};
+static_assert(sizeof(PackedVertex) == 12, "packed vertices should stay 12 bytes");
+
 //Width and height of the window
 const int WIDTH = 800;
 const int HEIGHT = 600;
+//frames the cpu can record and submit ahead of the gpu, each has its own semaphores, fence and retired resources
+const int MAX_FRAMES_IN_FLIGHT = 2;
 //paths for the model
 const std::string MODEL_PATH = "models/test1.obj";
 const std::string TEXTURE_PATH = "textures/binary_adder-RGBA.png";
@@ -187,9 +300,849 @@ private:
 	}
 };
 
+//bit scans for the allocator's size classes, both are only called with bits != 0
+static int getLowestBit(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return (int)index;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(bits);
+#else
+	int index = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+static int getHighestBit(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, bits);
+	return (int)index;
+#elif defined(__GNUC__)
+	return 63 - __builtin_clzll(bits);
+#else
+	int index = 0;
+	while (bits >>= 1) {
+		index++;
+	}
+	return index;
+#endif
+}
+
+//two level segregated fit allocator over one block of memory, allocating and freeing are O(1) whatever the number of ranges
+//free ranges are listed by size class, a power of two split into 16 steps, and two bitmaps find the first non empty class that is big enough
+//freed ranges merge with free neighbours straight away, so no two free ranges are ever next to each other
+class TlsfAllocator {
+public:
+	static const uint32_t NONE = UINT32_MAX;
+	//every offset and size is a multiple of this
+	static const VkDeviceSize MIN_SIZE = 16;
+
+	TlsfAllocator(VkDeviceSize _size) {
+		size = _size;
+		for (int f = 0; f < FL_COUNT; f++) {
+			slBitmaps[f] = 0;
+			for (int s = 0; s < SL_COUNT; s++) {
+				freeHeads[f][s] = NONE;
+			}
+		}
+		//the range at offset 0 is always ranges[0], nothing ever merges it away
+		Range whole = { 0, size, NONE, NONE, NONE, NONE, false };
+		ranges.push_back(whole);
+		insertFree(0);
+	}
+	//alignment has to be a power of two, as vulkan's are, handle is what free takes back
+	bool allocate(VkDeviceSize requested, VkDeviceSize alignment, uint32_t* handle, VkDeviceSize* offset) {
+		VkDeviceSize rangeSize = alignUp(std::max(requested, MIN_SIZE), MIN_SIZE);
+		alignment = std::max(alignment, MIN_SIZE);
+		//a range starting anywhere on MIN_SIZE needs at most alignment - MIN_SIZE of padding in front
+		VkDeviceSize searchSize = rangeSize + alignment - MIN_SIZE;
+		//rounded up to the next class boundary so every range in the class found is big enough
+		int bit = getHighestBit(searchSize);
+		if (bit >= SL_BITS) {
+			searchSize += ((VkDeviceSize)1 << (bit - SL_BITS)) - 1;
+		}
+		int fl;
+		int sl;
+		getSizeClass(searchSize, &fl, &sl);
+		uint32_t r = findFree(fl, sl);
+		if (r == NONE) {
+			return false;
+		}
+		removeFree(r);
+		VkDeviceSize padding = alignUp(ranges[r].offset, alignment) - ranges[r].offset;
+		//the padding in front becomes its own free range, the range before is in use so there's nothing to merge it with
+		if (padding > 0) {
+			uint32_t front = newRange();
+			Range range = { ranges[r].offset, padding, ranges[r].previous, r, NONE, NONE, false };
+			ranges[front] = range;
+			if (range.previous != NONE) {
+				ranges[range.previous].next = front;
+			}
+			ranges[r].previous = front;
+			ranges[r].offset += padding;
+			ranges[r].size -= padding;
+			insertFree(front);
+		}
+		if (ranges[r].size - rangeSize >= MIN_SIZE) {
+			uint32_t back = newRange();
+			Range range = { ranges[r].offset + rangeSize, ranges[r].size - rangeSize, r, ranges[r].next, NONE, NONE, false };
+			ranges[back] = range;
+			if (range.next != NONE) {
+				ranges[range.next].previous = back;
+			}
+			ranges[r].next = back;
+			ranges[r].size = rangeSize;
+			insertFree(back);
+		}
+		used += ranges[r].size;
+		allocationCount++;
+		*handle = r;
+		*offset = ranges[r].offset;
+		return true;
+	}
+	void free(uint32_t handle) {
+		uint32_t r = handle;
+		used -= ranges[r].size;
+		allocationCount--;
+		uint32_t next = ranges[r].next;
+		if (next != NONE && ranges[next].free) {
+			removeFree(next);
+			ranges[r].size += ranges[next].size;
+			unlink(next);
+		}
+		uint32_t previous = ranges[r].previous;
+		if (previous != NONE && ranges[previous].free) {
+			removeFree(previous);
+			ranges[previous].size += ranges[r].size;
+			unlink(r);
+			r = previous;
+		}
+		insertFree(r);
+	}
+	VkDeviceSize getSize() const { return size; }
+	VkDeviceSize getUsed() const { return used; }
+	uint32_t getAllocationCount() const { return allocationCount; }
+	//walks every range, only for stats
+	void getFreeRanges(size_t* count, VkDeviceSize* largest) const {
+		*count = 0;
+		*largest = 0;
+		for (uint32_t r = 0; r != NONE; r = ranges[r].next) {
+			if (ranges[r].free) {
+				(*count)++;
+				*largest = std::max(*largest, ranges[r].size);
+			}
+		}
+	}
+
+private:
+	static const int SL_BITS = 4;
+	static const int SL_COUNT = 1 << SL_BITS;
+	static const int FL_COUNT = 64;
+	//ranges in address order through previous/next, free ones are also in their class's list through previousFree/nextFree
+	struct Range { VkDeviceSize offset; VkDeviceSize size; uint32_t previous; uint32_t next; uint32_t previousFree; uint32_t nextFree; bool free; };
+	std::vector<Range> ranges;
+	std::vector<uint32_t> unusedRanges;
+	uint32_t freeHeads[FL_COUNT][SL_COUNT];
+	uint64_t flBitmap = 0;
+	uint32_t slBitmaps[FL_COUNT];
+	VkDeviceSize size;
+	VkDeviceSize used = 0;
+	uint32_t allocationCount = 0;
+
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+	static void getSizeClass(VkDeviceSize rangeSize, int* fl, int* sl) {
+		*fl = getHighestBit(rangeSize);
+		*sl = *fl < SL_BITS ? 0 : (int)((rangeSize >> (*fl - SL_BITS)) & (SL_COUNT - 1));
+	}
+	uint32_t findFree(int fl, int sl) const {
+		uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+		if (slMap == 0) {
+			uint64_t flMap = fl + 1 < FL_COUNT ? flBitmap & (~0ull << (fl + 1)) : 0;
+			if (flMap == 0) {
+				return NONE;
+			}
+			fl = getLowestBit(flMap);
+			slMap = slBitmaps[fl];
+		}
+		return freeHeads[fl][getLowestBit(slMap)];
+	}
+	uint32_t newRange() {
+		if (!unusedRanges.empty()) {
+			uint32_t r = unusedRanges.back();
+			unusedRanges.pop_back();
+			return r;
+		}
+		ranges.push_back(Range());
+		return (uint32_t)ranges.size() - 1;
+	}
+	//takes a range out of the address order once it has merged into its neighbour
+	void unlink(uint32_t r) {
+		if (ranges[r].previous != NONE) {
+			ranges[ranges[r].previous].next = ranges[r].next;
+		}
+		if (ranges[r].next != NONE) {
+			ranges[ranges[r].next].previous = ranges[r].previous;
+		}
+		unusedRanges.push_back(r);
+	}
+	void insertFree(uint32_t r) {
+		int fl;
+		int sl;
+		getSizeClass(ranges[r].size, &fl, &sl);
+		ranges[r].free = true;
+		ranges[r].previousFree = NONE;
+		ranges[r].nextFree = freeHeads[fl][sl];
+		if (freeHeads[fl][sl] != NONE) {
+			ranges[freeHeads[fl][sl]].previousFree = r;
+		}
+		freeHeads[fl][sl] = r;
+		flBitmap |= 1ull << fl;
+		slBitmaps[fl] |= 1u << sl;
+	}
+	void removeFree(uint32_t r) {
+		int fl;
+		int sl;
+		getSizeClass(ranges[r].size, &fl, &sl);
+		ranges[r].free = false;
+		if (ranges[r].previousFree != NONE) {
+			ranges[ranges[r].previousFree].nextFree = ranges[r].nextFree;
+		}
+		else {
+			freeHeads[fl][sl] = ranges[r].nextFree;
+		}
+		if (ranges[r].nextFree != NONE) {
+			ranges[ranges[r].nextFree].previousFree = ranges[r].previousFree;
+		}
+		if (freeHeads[fl][sl] == NONE) {
+			slBitmaps[fl] &= ~(1u << sl);
+			if (slBitmaps[fl] == 0) {
+				flBitmap &= ~(1ull << fl);
+			}
+		}
+	}
+};
+const uint32_t TlsfAllocator::NONE;
+const VkDeviceSize TlsfAllocator::MIN_SIZE;
+
+//hands out device memory from a few big vkAllocateMemory blocks per memory type instead of one allocation per resource,
+//drivers cap the number of allocations (maxMemoryAllocationCount, often 4096) and every allocation is slow
+//buffers and linear images never share a block with optimal images, which keeps the two further apart than bufferImageGranularity without tracking neighbours
+class DeviceMemoryAllocator {
+public:
+	struct Allocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		//host visible blocks stay mapped for their whole life, this points at the allocation's first byte
+		void* mapped = nullptr;
+		int block = -1;
+		uint32_t handle = 0;
+	};
+	const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	~DeviceMemoryAllocator() {
+		for (size_t b = 0; b < blocks.size(); b++) {
+			if (blocks[b]) {
+				vkFreeMemory(device, blocks[b]->memory, nullptr);
+			}
+		}
+	}
+	//called once the logical device exists
+	void init(VkPhysicalDevice physicalDevice, VkDevice _device) {
+		device = _device;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+	}
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+	Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimalImage) {
+		uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+		Allocation allocation;
+		for (size_t b = 0; b < blocks.size(); b++) {
+			MemoryBlock* block = blocks[b].get();
+			if (block && block->memoryType == memoryType && block->optimalImage == optimalImage && block->ranges.allocate(requirements.size, requirements.alignment, &allocation.handle, &allocation.offset)) {
+				return finishAllocation(allocation, (int)b, requirements.size);
+			}
+		}
+		//a resource bigger than half a block gets a block of its own size, it would waste most of a shared one
+		VkDeviceSize blockSize = getBlockSize(memoryType);
+		if (requirements.size > blockSize / 2) {
+			blockSize = requirements.size;
+		}
+		int b = createBlock(memoryType, optimalImage, blockSize);
+		if (!blocks[b]->ranges.allocate(requirements.size, requirements.alignment, &allocation.handle, &allocation.offset)) {
+			throw std::runtime_error("failed to allocate from a new memory block!");
+		}
+		return finishAllocation(allocation, b, requirements.size);
+	}
+	//an emptied block is given back to the driver unless it is the last one of its kind, which is kept for the next allocation
+	void free(const Allocation& allocation) {
+		MemoryBlock* block = blocks[allocation.block].get();
+		block->ranges.free(allocation.handle);
+		liveAllocations--;
+		if (block->ranges.getAllocationCount() > 0) {
+			return;
+		}
+		for (size_t b = 0; b < blocks.size(); b++) {
+			if (blocks[b] && (int)b != allocation.block && blocks[b]->memoryType == block->memoryType && blocks[b]->optimalImage == block->optimalImage) {
+				vkFreeMemory(device, block->memory, nullptr);
+				blocks[allocation.block].reset();
+				return;
+			}
+		}
+	}
+	//one line per block: its memory type, how full it is and how broken up its free space is
+	//fragmentation is how much of the free space is outside the largest free range, 0% means it is all in one piece
+	void printStats(std::ostream& out) const {
+		size_t blockCount = 0;
+		VkDeviceSize reserved = 0;
+		VkDeviceSize used = 0;
+		for (size_t b = 0; b < blocks.size(); b++) {
+			if (!blocks[b]) {
+				continue;
+			}
+			const MemoryBlock& block = *blocks[b];
+			size_t freeRanges;
+			VkDeviceSize largestFree;
+			block.ranges.getFreeRanges(&freeRanges, &largestFree);
+			VkDeviceSize freeSize = block.ranges.getSize() - block.ranges.getUsed();
+			out << "  block " << b << " type " << block.memoryType << (block.optimalImage ? " images" : " buffers") << ": " << block.ranges.getAllocationCount() << " allocations, "
+				<< block.ranges.getUsed() / 1024 << "/" << block.ranges.getSize() / 1024 << " KB used, " << freeRanges << " free ranges, fragmentation "
+				<< (freeSize > 0 ? 100.0 * (freeSize - largestFree) / freeSize : 0.0) << "%" << std::endl;
+			blockCount++;
+			reserved += block.ranges.getSize();
+			used += block.ranges.getUsed();
+		}
+		out << "device memory: " << liveAllocations << " resources in " << blockCount << " vkAllocateMemory blocks (limit " << maxAllocationCount << "), "
+			<< used / 1024 / 1024 << "/" << reserved / 1024 / 1024 << " MB used, " << driverAllocations << " driver allocations made in total" << std::endl;
+	}
+
+private:
+	struct MemoryBlock {
+		MemoryBlock(VkDeviceSize size) : ranges(size) {}
+		VkDeviceMemory memory;
+		uint32_t memoryType;
+		bool optimalImage;
+		void* mapped;
+		TlsfAllocator ranges;
+	};
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	uint32_t maxAllocationCount = 0;
+	//freed blocks leave a null slot so the block index in each Allocation stays valid
+	std::vector<std::unique_ptr<MemoryBlock>> blocks;
+	size_t liveAllocations = 0;
+	size_t driverAllocations = 0;
+
+	//small heaps (integrated gpus, the host visible window on discrete ones) get smaller blocks so one block doesn't take a big share
+	VkDeviceSize getBlockSize(uint32_t memoryType) const {
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+		VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+		while (blockSize > TlsfAllocator::MIN_SIZE * 1024 && blockSize > heapSize / 8) {
+			blockSize /= 2;
+		}
+		return blockSize;
+	}
+	int createBlock(uint32_t memoryType, bool optimalImage, VkDeviceSize size) {
+		std::unique_ptr<MemoryBlock> block(new MemoryBlock(size));
+		block->memoryType = memoryType;
+		block->optimalImage = optimalImage;
+		block->mapped = nullptr;
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate device memory block!");
+		}
+		driverAllocations++;
+		if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			vkMapMemory(device, block->memory, 0, size, 0, &block->mapped);
+		}
+		for (size_t b = 0; b < blocks.size(); b++) {
+			if (!blocks[b]) {
+				blocks[b] = std::move(block);
+				return (int)b;
+			}
+		}
+		blocks.push_back(std::move(block));
+		return (int)blocks.size() - 1;
+	}
+	Allocation finishAllocation(Allocation allocation, int b, VkDeviceSize size) {
+		allocation.block = b;
+		allocation.memory = blocks[b]->memory;
+		allocation.size = size;
+		if (blocks[b]->mapped) {
+			allocation.mapped = (char*)blocks[b]->mapped + allocation.offset;
+		}
+		liveAllocations++;
+		return allocation;
+	}
+};
+
+//owns one allocation and gives it back when it is replaced or goes out of scope, the sub-allocated counterpart of VDeleter<VkDeviceMemory>
+class DeviceMemory {
+public:
+	DeviceMemory(DeviceMemoryAllocator& _allocator) { allocator = &_allocator; }
+	~DeviceMemory() {
+		release();
+	}
+	DeviceMemory(const DeviceMemory&) = delete;
+	DeviceMemory& operator=(const DeviceMemory&) = delete;
+
+	void assign(const DeviceMemoryAllocator::Allocation& _allocation) {
+		release();
+		allocation = _allocation;
+	}
+	void release() {
+		if (allocation.memory != VK_NULL_HANDLE) {
+			allocator->free(allocation);
+		}
+		allocation = DeviceMemoryAllocator::Allocation();
+	}
+	VkDeviceMemory getMemory() const { return allocation.memory; }
+	VkDeviceSize getOffset() const { return allocation.offset; }
+	//only for host visible memory, which is always mapped
+	void* getMapped() const { return allocation.mapped; }
+
+private:
+	DeviceMemoryAllocator* allocator;
+	DeviceMemoryAllocator::Allocation allocation;
+};
+
+//one persistently mapped staging buffer every upload goes through, instead of a staging buffer made, mapped and destroyed per upload
+//space is handed out front to back at positions that only grow (the offset is position % capacity), copies pile up until flush records them
+//into one command buffer, and that batch's fence says when its part of the ring can be written again
+//with a separate transfer queue the copies run there alongside rendering, and each batch hands what it wrote over to the graphics queue
+class StagingRing {
+public:
+	~StagingRing() {
+		release();
+	}
+	//queue and commandPool are the graphics ones, the batches go there unless useTransferQueue is called
+	void init(VkDevice _device, VkQueue _queue, VkCommandPool _commandPool, VkBuffer _buffer, void* _mapped, VkDeviceSize _capacity) {
+		device = _device;
+		queue = _queue;
+		commandPool = _commandPool;
+		buffer = _buffer;
+		mapped = (char*)_mapped;
+		capacity = _capacity;
+	}
+	//copies are recorded on transferPool and submitted to transferQueue, the destinations are exclusive to the graphics family so every batch
+	//ends with release barriers there and a second, tiny graphics submission that waits on a semaphore and acquires the same ranges
+	void useTransferQueue(VkQueue _transferQueue, VkCommandPool _transferPool, uint32_t _transferFamily, uint32_t _graphicsFamily) {
+		transferQueue = _transferQueue;
+		transferPool = _transferPool;
+		transferFamily = _transferFamily;
+		graphicsFamily = _graphicsFamily;
+	}
+	//the copy is made at the next flush, so dst has to live until then, uploads bigger than a quarter of the ring stream through it in pieces
+	void uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset) {
+		const char* bytes = (const char*)data;
+		VkDeviceSize pieceSize = capacity / 4;
+		for (VkDeviceSize done = 0; done < size; done += pieceSize) {
+			VkDeviceSize piece = std::min(pieceSize, size - done);
+			VkDeviceSize offset = reserve(piece, COPY_ALIGNMENT);
+			memcpy(mapped + offset, bytes + done, (size_t)piece);
+			PendingCopy copy = {};
+			copy.buffer = dst;
+			copy.bufferCopy.srcOffset = offset;
+			copy.bufferCopy.dstOffset = dstOffset + done;
+			copy.bufferCopy.size = piece;
+			pending.push_back(copy);
+		}
+		uploadCount++;
+		uploadedBytes += size;
+	}
+	//tightly packed texels into the whole of a 2d colour image, whatever it held is dropped and it ends up in finalLayout
+	//it streams through the ring in bands of rows no bigger than a quarter of it, so a band can end up in a later batch than the one before
+	void uploadImage(const void* data, uint32_t width, uint32_t height, uint32_t texelSize, VkImage dst, VkImageLayout finalLayout) {
+		const char* bytes = (const char*)data;
+		VkDeviceSize rowSize = (VkDeviceSize)width * texelSize;
+		uint32_t bandRows = (uint32_t)std::max<VkDeviceSize>(1, std::min<VkDeviceSize>(height, capacity / 4 / rowSize));
+		for (uint32_t row = 0; row < height; row += bandRows) {
+			uint32_t rows = std::min(bandRows, height - row);
+			VkDeviceSize offset = reserve(rows * rowSize, COPY_ALIGNMENT);
+			memcpy(mapped + offset, bytes + row * rowSize, (size_t)(rows * rowSize));
+			PendingCopy copy = {};
+			copy.image = dst;
+			copy.finalLayout = finalLayout;
+			copy.firstBand = row == 0;
+			copy.lastBand = row + rows == height;
+			copy.imageCopy.bufferOffset = offset;
+			copy.imageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy.imageCopy.imageSubresource.layerCount = 1;
+			copy.imageCopy.imageOffset = { 0, (int32_t)row, 0 };
+			copy.imageCopy.imageExtent = { width, rows, 1 };
+			pending.push_back(copy);
+		}
+		uploadCount++;
+		uploadedBytes += rowSize * height;
+	}
+	//a layout change with no copy behind it, recorded on the graphics queue in the next batch's closing barrier after its copies
+	void transitionImage(const VkImageMemoryBarrier& barrier, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages) {
+		transitions.push_back(barrier);
+		transitionSrcStages |= srcStages;
+		transitionDstStages |= dstStages;
+	}
+	//submits everything staged since the last flush as one batch, with at most one barrier before the copies and one after
+	//the closing barrier makes the data visible to the draws and shader reads submitted after it and carries every queued transition
+	void flush() {
+		if (pending.empty() && transitions.empty()) {
+			return;
+		}
+		reclaim();
+		bool transfer = transferQueue != VK_NULL_HANDLE && !pending.empty();
+		Batch batch = {};
+		batch.commandBuffer = beginCommands(transfer ? transferPool : commandPool);
+		//an image's bands are next to each other in pending, one barrier before the first of them in this batch
+		//an image starts from undefined, everything in it is overwritten, unless earlier bands went in a previous batch
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		VkPipelineStageFlags imageSrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		for (size_t i = 0; i < pending.size(); i++) {
+			if (pending[i].image != VK_NULL_HANDLE && (i == 0 || pending[i - 1].image != pending[i].image)) {
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = pending[i].image;
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				if (!pending[i].firstBand) {
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+					imageSrcStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				}
+				imageBarriers.push_back(barrier);
+			}
+		}
+		if (!imageBarriers.empty()) {
+			vkCmdPipelineBarrier(batch.commandBuffer, imageSrcStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+		}
+		//neighbouring copies into the same buffer or image go in one command, each run of buffer copies is one range to hand over
+		//an image only leaves TRANSFER_DST_OPTIMAL (and is handed over) in the batch that has its last band
+		std::vector<VkBufferCopy> regions;
+		std::vector<VkBufferImageCopy> imageRegions;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		imageBarriers.clear();
+		for (size_t i = 0; i < pending.size(); i++) {
+			if (pending[i].image != VK_NULL_HANDLE) {
+				imageRegions.push_back(pending[i].imageCopy);
+				if (i + 1 == pending.size() || pending[i + 1].image != pending[i].image) {
+					vkCmdCopyBufferToImage(batch.commandBuffer, buffer, pending[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)imageRegions.size(), imageRegions.data());
+					imageRegions.clear();
+				}
+				if (pending[i].lastBand) {
+					VkImageMemoryBarrier barrier = {};
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+					barrier.newLayout = pending[i].finalLayout;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = pending[i].image;
+					barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+					imageBarriers.push_back(barrier);
+				}
+				continue;
+			}
+			regions.push_back(pending[i].bufferCopy);
+			if (i + 1 == pending.size() || pending[i + 1].buffer != pending[i].buffer) {
+				vkCmdCopyBuffer(batch.commandBuffer, buffer, pending[i].buffer, (uint32_t)regions.size(), regions.data());
+				if (transfer) {
+					VkBufferMemoryBarrier barrier = {};
+					barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+					barrier.buffer = pending[i].buffer;
+					barrier.offset = regions[0].dstOffset;
+					VkDeviceSize end = 0;
+					for (size_t j = 0; j < regions.size(); j++) {
+						barrier.offset = std::min(barrier.offset, regions[j].dstOffset);
+						end = std::max(end, regions[j].dstOffset + regions[j].size);
+					}
+					barrier.size = end - barrier.offset;
+					bufferBarriers.push_back(barrier);
+				}
+				regions.clear();
+			}
+		}
+		if (!transfer) {
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = READ_ACCESS;
+			for (size_t i = 0; i < imageBarriers.size(); i++) {
+				imageBarriers[i].dstAccessMask = READ_ACCESS;
+			}
+			imageBarriers.insert(imageBarriers.end(), transitions.begin(), transitions.end());
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | transitionSrcStages, READ_STAGES | transitionDstStages, 0, pending.empty() ? 0 : 1, &barrier,
+				0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+			vkEndCommandBuffer(batch.commandBuffer);
+			batch.fence = takeFence();
+			submit(queue, batch.commandBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE, batch.fence);
+		}
+		else {
+			//release on the transfer queue, the access and stage on the side that doesn't own the resource are ignored
+			//an image's layout change is given in both halves and happens once
+			for (auto& barrier : bufferBarriers) {
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.srcQueueFamilyIndex = transferFamily;
+				barrier.dstQueueFamilyIndex = graphicsFamily;
+			}
+			for (auto& barrier : imageBarriers) {
+				barrier.srcQueueFamilyIndex = transferFamily;
+				barrier.dstQueueFamilyIndex = graphicsFamily;
+			}
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+				(uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)imageBarriers.size(), imageBarriers.data());
+			vkEndCommandBuffer(batch.commandBuffer);
+			batch.semaphore = takeSemaphore();
+			submit(transferQueue, batch.commandBuffer, VK_NULL_HANDLE, batch.semaphore, VK_NULL_HANDLE);
+
+			//the matching acquire on the graphics queue along with the queued transitions, anything submitted there later is ordered after it
+			for (auto& barrier : bufferBarriers) {
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = READ_ACCESS;
+			}
+			for (auto& barrier : imageBarriers) {
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = READ_ACCESS;
+			}
+			imageBarriers.insert(imageBarriers.end(), transitions.begin(), transitions.end());
+			batch.acquireCommandBuffer = beginCommands(commandPool);
+			vkCmdPipelineBarrier(batch.acquireCommandBuffer, READ_STAGES | transitionSrcStages, READ_STAGES | transitionDstStages, 0, 0, nullptr,
+				(uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)imageBarriers.size(), imageBarriers.data());
+			vkEndCommandBuffer(batch.acquireCommandBuffer);
+			//the fence is on the graphics side, which can't finish before the copies it waits on
+			batch.fence = takeFence();
+			submit(queue, batch.acquireCommandBuffer, batch.semaphore, VK_NULL_HANDLE, batch.fence);
+		}
+		batch.end = head;
+		batches.push_back(batch);
+		submitted = head;
+		pending.clear();
+		transitions.clear();
+		transitionSrcStages = 0;
+		transitionDstStages = 0;
+		batchCount++;
+	}
+	//flushes and waits for every batch, for when the destinations are about to be replaced
+	void waitIdle() {
+		flush();
+		while (!batches.empty()) {
+			waitOldest();
+		}
+	}
+	//has to run before the command pool or the ring's buffer go away
+	void release() {
+		if (device == VK_NULL_HANDLE) {
+			return;
+		}
+		waitIdle();
+		for (size_t i = 0; i < spareFences.size(); i++) {
+			vkDestroyFence(device, spareFences[i], nullptr);
+		}
+		for (size_t i = 0; i < spareSemaphores.size(); i++) {
+			vkDestroySemaphore(device, spareSemaphores[i], nullptr);
+		}
+		spareFences.clear();
+		spareSemaphores.clear();
+		device = VK_NULL_HANDLE;
+	}
+	void printStats(std::ostream& out) const {
+		out << "staging ring: " << capacity / 1024 / 1024 << " MB on the " << (transferQueue != VK_NULL_HANDLE ? "transfer" : "graphics") << " queue, " << uploadCount << " uploads, " << uploadedBytes / 1024 / 1024 << " MB in " << batchCount << " batches, "
+			<< stallCount << " waits for space" << std::endl;
+	}
+
+private:
+	//bufferOffset of an image copy has to be a multiple of the texel size, 16 covers every format this uploads
+	const VkDeviceSize COPY_ALIGNMENT = 16;
+	//everything an upload can be read by afterwards
+	const VkAccessFlags READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	const VkPipelineStageFlags READ_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	struct PendingCopy {
+		VkBuffer buffer;
+		VkBufferCopy bufferCopy;
+		VkImage image;
+		VkBufferImageCopy imageCopy;
+		VkImageLayout finalLayout;
+		bool firstBand;
+		bool lastBand;
+	};
+	//everything before end is free again once fence is signalled, the acquire half and the semaphore are only there with a transfer queue
+	struct Batch {
+		VkFence fence;
+		VkCommandBuffer commandBuffer;
+		VkCommandBuffer acquireCommandBuffer;
+		VkSemaphore semaphore;
+		uint64_t end;
+	};
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue;
+	VkCommandPool commandPool;
+	VkQueue transferQueue = VK_NULL_HANDLE;
+	VkCommandPool transferPool = VK_NULL_HANDLE;
+	uint32_t transferFamily = VK_QUEUE_FAMILY_IGNORED;
+	uint32_t graphicsFamily = VK_QUEUE_FAMILY_IGNORED;
+	VkBuffer buffer;
+	char* mapped = nullptr;
+	VkDeviceSize capacity = 0;
+	//staged data runs from tail to head, the part from submitted to head is still waiting for a flush
+	uint64_t head = 0;
+	uint64_t submitted = 0;
+	uint64_t tail = 0;
+	std::vector<PendingCopy> pending;
+	std::vector<VkImageMemoryBarrier> transitions;
+	VkPipelineStageFlags transitionSrcStages = 0;
+	VkPipelineStageFlags transitionDstStages = 0;
+	std::deque<Batch> batches;
+	std::vector<VkFence> spareFences;
+	std::vector<VkSemaphore> spareSemaphores;
+	size_t uploadCount = 0;
+	VkDeviceSize uploadedBytes = 0;
+	size_t batchCount = 0;
+	size_t stallCount = 0;
+
+	//finds room for size bytes, a piece never wraps around the end of the ring, it starts again at the front instead
+	//when the ring is full everything staged is flushed and the oldest batch is waited on
+	VkDeviceSize reserve(VkDeviceSize size, VkDeviceSize alignment) {
+		if (size > capacity) {
+			throw std::runtime_error("staging upload bigger than the ring!");
+		}
+		while (true) {
+			uint64_t start = (head + alignment - 1) & ~(uint64_t)(alignment - 1);
+			if (start % capacity + size > capacity) {
+				start += capacity - start % capacity;
+			}
+			if (start + size - tail <= capacity) {
+				head = start + size;
+				return start % capacity;
+			}
+			reclaim();
+			if (start + size - tail <= capacity) {
+				continue;
+			}
+			//nothing is in use, but the skipped end of the ring still counts, so start the empty ring again at its front
+			if (tail == head) {
+				head = tail = start - start % capacity;
+				continue;
+			}
+			if (head > submitted) {
+				flush();
+			}
+			waitOldest();
+			stallCount++;
+		}
+	}
+	//frees the space of every batch the gpu has finished, in order
+	void reclaim() {
+		while (!batches.empty() && vkGetFenceStatus(device, batches.front().fence) == VK_SUCCESS) {
+			retireOldest();
+		}
+	}
+	void waitOldest() {
+		vkWaitForFences(device, 1, &batches.front().fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		retireOldest();
+	}
+	void retireOldest() {
+		Batch& batch = batches.front();
+		vkResetFences(device, 1, &batch.fence);
+		spareFences.push_back(batch.fence);
+		if (batch.semaphore != VK_NULL_HANDLE) {
+			spareSemaphores.push_back(batch.semaphore);
+			vkFreeCommandBuffers(device, transferPool, 1, &batch.commandBuffer);
+			vkFreeCommandBuffers(device, commandPool, 1, &batch.acquireCommandBuffer);
+		}
+		else {
+			vkFreeCommandBuffers(device, commandPool, 1, &batch.commandBuffer);
+		}
+		tail = batch.end;
+		batches.pop_front();
+	}
+	VkCommandBuffer beginCommands(VkCommandPool pool) {
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = pool;
+		allocInfo.commandBufferCount = 1;
+		VkCommandBuffer commandBuffer;
+		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		return commandBuffer;
+	}
+	//wait is waited on before the read stages, signal is signalled when the command buffer is done, either can be VK_NULL_HANDLE
+	void submit(VkQueue submitQueue, VkCommandBuffer commandBuffer, VkSemaphore wait, VkSemaphore signal, VkFence fence) {
+		VkPipelineStageFlags waitStage = READ_STAGES;
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = wait != VK_NULL_HANDLE ? 1 : 0;
+		submitInfo.pWaitSemaphores = &wait;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = signal != VK_NULL_HANDLE ? 1 : 0;
+		submitInfo.pSignalSemaphores = &signal;
+		if (vkQueueSubmit(submitQueue, 1, &submitInfo, fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit staging copies!");
+		}
+	}
+	VkFence takeFence() {
+		VkFence fence;
+		if (spareFences.empty()) {
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create staging fence!");
+			}
+			return fence;
+		}
+		fence = spareFences.back();
+		spareFences.pop_back();
+		return fence;
+	}
+	//a binary semaphore is unsignalled again once its wait has run, so it can be reused as soon as the batch's fence is
+	VkSemaphore takeSemaphore() {
+		VkSemaphore semaphore;
+		if (spareSemaphores.empty()) {
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create staging semaphore!");
+			}
+			return semaphore;
+		}
+		semaphore = spareSemaphores.back();
+		spareSemaphores.pop_back();
+		return semaphore;
+	}
+};
+
 struct QueueFamilyIndices {
 	int graphicsFamily = -1;
 	int presentFamily = -1;
+	//a family for uploads apart from graphics, -1 when the device has none and uploads stay on the graphics queue
+	int transferFamily = -1;
 
 	bool isComplete() {
 		return graphicsFamily >= 0 && presentFamily >= 0;
@@ -417,2280 +1370,5841 @@ struct primitive {
 	std::string name;
 };
 
-enum blockType { wire, inverter, andGate, orGate, xorGate };
-enum blockDirection { positiveX, negativeX, positiveY, negativeY, positiveZ, negativeZ };
-struct Block { Block(int x, int y, int z, blockType _type, blockDirection _direction, VDeleter<VkDevice>* _blockDevice) { position = glm::vec3(x, y, z); type = _type; direction = _direction; blockDevice = _blockDevice; } glm::vec3 position; blockType type; blockDirection direction; VDeleter<VkDevice>* blockDevice;
-VDeleter<VkBuffer> vertexBuffer{ *blockDevice, vkDestroyBuffer };
-VDeleter<VkDeviceMemory> vertexBufferMemory{ *blockDevice, vkFreeMemory };
-VDeleter<VkBuffer> indexBuffer{ *blockDevice, vkDestroyBuffer };
-VDeleter<VkDeviceMemory> indexBufferMemory{ *blockDevice, vkFreeMemory };
-};
+enum blockType : uint8_t { wire, inverter, andGate, orGate, xorGate };
+enum blockDirection : uint8_t { positiveX, negativeX, positiveY, negativeY, positiveZ, negativeZ };
+//plain 16 byte block record, no gpu resources or pointers so it can be copied around freely
+struct Block { Block() {} Block(int x, int y, int z, blockType _type, blockDirection _direction) { position = glm::ivec3(x, y, z); type = _type; direction = _direction; } glm::ivec3 position; blockType type; blockDirection direction; };
+static_assert(sizeof(Block) <= 16 && std::is_trivially_copyable<Block>::value, "blocks should stay small plain records");
 
-class Blocks {
+//first fit allocator over a fixed number of slots, freed ranges merge with their neighbours so the space doesn't splinter
+class RangeAllocator {
 public:
-	Blocks() {}
-
-	void correctCameraWithBlocks(glm::vec3* cameraMin, glm::vec3* cameraMax, glm::vec3* cameraVel) {
-		glm::vec3 test = glm::vec3(cameraMin->x, cameraMin->y, cameraMin->y);
-		for (int i = 0; i < blocks.size(); i++) {
-			correctBoundingBox(cameraMin, cameraMax, &blocks[i].position, &glm::vec3(blocks[i].position.x+1, blocks[i].position.y + 1, blocks[i].position.z + 1), cameraVel);
+	RangeAllocator(uint32_t _capacity) { capacity = _capacity; freeRanges[0] = _capacity; }
+	bool allocate(uint32_t count, uint32_t* offset) {
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+			if (it->second < count) {
+				continue;
+			}
+			*offset = it->first;
+			uint32_t start = it->first + count;
+			uint32_t remaining = it->second - count;
+			freeRanges.erase(it);
+			if (remaining > 0) {
+				freeRanges[start] = remaining;
+			}
+			used += count;
+			return true;
 		}
+		return false;
 	}
-	VDeleter<VkDevice>* blocksDevice;
-	void init(std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
-		vertices = _vertices;
-		indices = _indices;
-		//for (int i = 0; i < 200; i++) {
-			addBlock(((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120, inverter);
-		//}
-		/*
-		for (int i = 0; i < 25600; i++) {
-			addBlock(((double)rand() / (RAND_MAX)) * 400 - 600, ((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400);
+	void free(uint32_t offset, uint32_t count) {
+		used -= count;
+		auto next = freeRanges.lower_bound(offset);
+		if (next != freeRanges.begin()) {
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset) {
+				offset = previous->first;
+				count += previous->second;
+				freeRanges.erase(previous);
+			}
 		}
-
-		for (int i = 0; i < 25600; i++) {
-			addBlock(((double)rand() / (RAND_MAX)) * 400 -600, ((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400 - 600);
+		if (next != freeRanges.end() && offset + count == next->first) {
+			count += next->second;
+			freeRanges.erase(next);
 		}
-
-		for (int i = 0; i < 25600; i++) {
-			addBlock(((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400 - 600);
-		}*/
+		freeRanges[offset] = count;
 	}
+	uint32_t getCapacity() const { return capacity; }
+	uint32_t getUsed() const { return used; }
+	size_t getFreeRangeCount() const { return freeRanges.size(); }
+private:
+	uint32_t capacity;
+	uint32_t used = 0;
+	//offset -> length of every gap
+	std::map<uint32_t, uint32_t> freeRanges;
+};
+
+//a run of a mesh's indices that only touches 65536 vertices from vertexBase, so they fit 16 bits relative to it
+struct IndexSection {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t vertexBase;
+};
 
-	void addBlock(int x, int y, int z, blockType type) {
-		if (!doesBlockExist(x, y, z)) {
-			blocks.push_back(Block(x, y, z, type, positiveY, blocksDevice));
+//splits a mesh into sections that can each be drawn with 16 bit indices and vertexOffset at their vertexBase
+//each new section starts at the lowest vertex any later triangle uses, meshes built block by block only ever move forward so they split cleanly
+//returns false if a single triangle spans too many vertices, the mesh then keeps its 32 bit indices
+bool splitShortIndices(const std::vector<uint32_t>& indices, std::vector<uint16_t>* shortIndices, std::vector<IndexSection>* sections) {
+	sections->clear();
+	shortIndices->resize(indices.size());
+	size_t triangleCount = indices.size() / 3;
+	//lowest vertex used by each triangle and every one after it
+	std::vector<uint32_t> laterLowest(triangleCount + 1, UINT32_MAX);
+	for (size_t t = triangleCount; t-- > 0;) {
+		uint32_t lowest = std::min(indices[t * 3], std::min(indices[t * 3 + 1], indices[t * 3 + 2]));
+		laterLowest[t] = std::min(lowest, laterLowest[t + 1]);
+	}
+	IndexSection section = {};
+	for (size_t t = 0; t < triangleCount; t++) {
+		uint32_t highest = std::max(indices[t * 3], std::max(indices[t * 3 + 1], indices[t * 3 + 2]));
+		if (t == 0 || highest - section.vertexBase > 0xFFFF) {
+			if (t > 0) {
+				section.indexCount = (uint32_t)(t * 3) - section.firstIndex;
+				sections->push_back(section);
+			}
+			section.firstIndex = (uint32_t)(t * 3);
+			section.vertexBase = laterLowest[t];
+			if (highest - section.vertexBase > 0xFFFF) {
+				sections->clear();
+				shortIndices->clear();
+				return false;
+			}
 		}
-	}
-	void addBlock(int x, int y, int z, blockType type, blockDirection direction) {
-		if (!doesBlockExist(x, y, z)) {
-			blocks.push_back(Block(x, y, z, type, direction, blocksDevice));
+		for (int i = 0; i < 3; i++) {
+			(*shortIndices)[t * 3 + i] = (uint16_t)(indices[t * 3 + i] - section.vertexBase);
 		}
 	}
-	int getVectorSize() {
-		return blocks.size();
-	}
-	bool removeBlock(int x, int y, int z) {
-		if (doesBlockExist(x, y, z)) {
-			int index = getBlock(x, y, z);
-			blocks.erase(blocks.begin() + index);
-			return true;
-		}
-		return false;
-	}
-	bool doesBlockExist(int x, int y, int z) {
-		for (int i = 0; i < blocks.size(); i++) {
-			if (blocks[i].position == glm::vec3(x, y, z)) {
-				return true;
-			}
-		}
-		return false;
-	}
-	int getBlock(int x, int y, int z) {
-		for (int i = 0; i < blocks.size(); i++) {
-			if (blocks[i].position == glm::vec3(x, y, z)) {
-				return i;
-			}
-		}
-		return NULL;
-	}
-	std::vector<Block> blocks;
-private:
-	std::vector<Vertex>* vertices;
-	std::vector<uint32_t>* indices;
-
-};
-
-void addVectorsWithOffset(std::vector<Vertex>* originalVertices, std::vector<uint32_t>* originalIndices, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, glm::vec3 offset) {
-	int temp = originalVertices->size();
-	for (int i = 0; i < vertices->size(); i++) {
-		vertices->at(i).pos += offset;
-		originalVertices->push_back(vertices->at(i));
-		vertices->at(i).pos -= offset;
-	}
-	for (int i = 0; i < indices->size(); i++) {
-		originalIndices->push_back(indices->at(i) + temp);
+	if (triangleCount > 0) {
+		section.indexCount = (uint32_t)(triangleCount * 3) - section.firstIndex;
+		sections->push_back(section);
 	}
+	return true;
 }
 
-class WorkSpace {
-public:
-	void run() {
-		initWindow();
-		blocks.init(&vertices, &indices);
-		//drawBlocks();
-		initVulkan();
-
-		mainLoop();
-	}
-	
-private:
-	GLFWwindow* window;
-
-	VDeleter<VkInstance> instance{ vkDestroyInstance };
-	VDeleter<VkDebugReportCallbackEXT> callback{ instance, DestroyDebugReportCallbackEXT };
-	VDeleter<VkSurfaceKHR> surface{ instance, vkDestroySurfaceKHR };
-
-	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-	VDeleter<VkDevice> device{ vkDestroyDevice };
-
-	VkQueue graphicsQueue;
-	VkQueue presentQueue;
-
-	VDeleter<VkSwapchainKHR> swapChain{ device, vkDestroySwapchainKHR };
-	std::vector<VkImage> swapChainImages;
-	VkFormat swapChainImageFormat;
-	VkExtent2D swapChainExtent;
-	std::vector<VDeleter<VkImageView>> swapChainImageViews;
-	std::vector<VDeleter<VkFramebuffer>> swapChainFramebuffers;
-
-	VDeleter<VkRenderPass> renderPass{ device, vkDestroyRenderPass };
-	VDeleter<VkDescriptorSetLayout> descriptorSetLayout{ device, vkDestroyDescriptorSetLayout };
-	VDeleter<VkPipelineLayout> pipelineLayout{ device, vkDestroyPipelineLayout };
-	VDeleter<VkPipeline> graphicsPipeline{ device, vkDestroyPipeline };
-
-	VDeleter<VkCommandPool> commandPool{ device, vkDestroyCommandPool };
-
-	VDeleter<VkImage> textureImage{ device, vkDestroyImage };
-	VDeleter<VkDeviceMemory> textureImageMemory{ device, vkFreeMemory };
-	VDeleter<VkImageView> textureImageView{ device, vkDestroyImageView };
-	VDeleter<VkSampler> textureSampler{ device, vkDestroySampler };
-
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-
-	VDeleter<VkBuffer> vertexBuffer{ device, vkDestroyBuffer };
-	VDeleter<VkDeviceMemory> vertexBufferMemory{ device, vkFreeMemory };
-	VDeleter<VkBuffer> indexBuffer{ device, vkDestroyBuffer };
-	VDeleter<VkDeviceMemory> indexBufferMemory{ device, vkFreeMemory };
-
-	VDeleter<VkBuffer> uniformStagingBuffer{ device, vkDestroyBuffer };
-	VDeleter<VkDeviceMemory> uniformStagingBufferMemory{ device, vkFreeMemory };
-	VDeleter<VkBuffer> uniformBuffer{ device, vkDestroyBuffer };
-	VDeleter<VkDeviceMemory> uniformBufferMemory{ device, vkFreeMemory };
-
-	VDeleter<VkDescriptorPool> descriptorPool{ device, vkDestroyDescriptorPool };
-	VkDescriptorSet descriptorSet;
-
-	std::vector<VkCommandBuffer> commandBuffers;
+//shared vertex and index buffers many chunk meshes are packed into, each page holds one vertex format and one index width
+//chunks take ranges out of it and are drawn with firstIndex and vertexOffset, so a page's buffers are bound once for all of them
+const uint32_t CHUNK_PAGE_VERTICES = 1 << 20;
+const uint32_t CHUNK_PAGE_INDICES = 3 << 20;
+struct ChunkPage { ChunkPage(const VDeleter<VkDevice>& device, DeviceMemoryAllocator& allocator, uint32_t vertexCapacity, uint32_t indexCapacity) : vertexBuffer{ device, vkDestroyBuffer }, vertexBufferMemory{ allocator }, indexBuffer{ device, vkDestroyBuffer }, indexBufferMemory{ allocator }, vertexRanges(vertexCapacity), indexRanges(indexCapacity) {}
+VDeleter<VkBuffer> vertexBuffer;
+DeviceMemory vertexBufferMemory;
+VDeleter<VkBuffer> indexBuffer;
+DeviceMemory indexBufferMemory;
+//packed pages hold PackedVertex and are drawn with the packed pipeline
+bool packed = false;
+VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+RangeAllocator vertexRanges;
+RangeAllocator indexRanges;
+};
 
-	VDeleter<VkSemaphore> imageAvailableSemaphore{ device, vkDestroySemaphore };
-	VDeleter<VkSemaphore> renderFinishedSemaphore{ device, vkDestroySemaphore };
+//where the geometry of every block in one chunk lives, copied and box meshes take a range of a ChunkPage
+//the instanced path only fills the instance buffer, grouped by primitive with instanceCounts[primitive] in each group
+struct ChunkMesh { ChunkMesh(const VDeleter<VkDevice>& device, DeviceMemoryAllocator& allocator) : instanceBuffer{ device, vkDestroyBuffer }, instanceBufferMemory{ allocator } {}
+int page = -1;
+uint32_t vertexOffset = 0;
+uint32_t vertexCount = 0;
+uint32_t firstIndex = 0;
+uint32_t indexCount = 0;
+//one draw per section, relative to firstIndex and vertexOffset
+std::vector<IndexSection> sections;
+//packed meshes need the chunk's origin to be drawn
+glm::ivec3 origin;
+VDeleter<VkBuffer> instanceBuffer;
+DeviceMemory instanceBufferMemory;
+std::vector<uint32_t> instanceCounts;
+};
 
-	VDeleter<VkImage> depthImage{ device, vkDestroyImage };
-	VDeleter<VkDeviceMemory> depthImageMemory{ device, vkFreeMemory };
+//packs a block position into a single 64 bit key, 21 bits per axis (two's complement, so negative coordinates work)
+inline uint64_t packBlockPosition(int x, int y, int z) {
+	return ((uint64_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(y & 0x1FFFFF) << 21) | (uint64_t)(z & 0x1FFFFF);
+}
 
-	VDeleter<VkImageView> depthImageView{ device, vkDestroyImageView };
-	Blocks blocks;
-	
+//the world is split into 16x16x16 chunks, block coordinates are turned into chunk coordinates with a shift (rounds down for negatives too) and into a cell inside the chunk with a mask
+const int CHUNK_SHIFT = 4;
+const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+const int CHUNK_MASK = CHUNK_SIZE - 1;
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
 
-	std::vector<primitive> primitives;
+inline int chunkCell(int localX, int localY, int localZ) {
+	return localX | (localZ << CHUNK_SHIFT) | (localY << (CHUNK_SHIFT * 2));
+}
 
-	void initWindow() {
-		
-		glfwInit();
+//a block stored in a chunk is a single byte, type in the top 5 bits and direction in the bottom 3
+inline uint8_t packBlock(blockType type, blockDirection direction) {
+	return (uint8_t)((type << 3) | direction);
+}
 
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);//may need to remove this
+//interleaves the bits of the three coordinates (z-order curve), blocks sorted by this code are close in memory when they are close in space
+//coordinates are biased so negative ones sort below positive ones, 21 bits per axis like packBlockPosition
+inline uint64_t spreadMortonBits(uint32_t value) {
+	uint64_t bits = value & 0x1FFFFF;
+	bits = (bits | bits << 32) & 0x1F00000000FFFFull;
+	bits = (bits | bits << 16) & 0x1F0000FF0000FFull;
+	bits = (bits | bits << 8) & 0x100F00F00F00F00Full;
+	bits = (bits | bits << 4) & 0x10C30C30C30C30C3ull;
+	bits = (bits | bits << 2) & 0x1249249249249249ull;
+	return bits;
+}
+inline uint64_t mortonCode(int x, int y, int z) {
+	const int bias = 1 << 20;
+	return spreadMortonBits(x + bias) | (spreadMortonBits(y + bias) << 1) | (spreadMortonBits(z + bias) << 2);
+}
 
-		window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
-		glfwSetKeyCallback(window, key_callback);
-		glfwSetMouseButtonCallback(window, mouse_button_callback);
-		glfwSetWindowFocusCallback(window, window_focus_callback);
-		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+//stable reference to a block, index is the block's slot and generation is bumped every time the slot is freed
+//so a handle to a removed block stops being valid even after the slot is reused
+struct BlockHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+	bool isValid() const { return index != UINT32_MAX; }
+	bool operator==(const BlockHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const BlockHandle& other) const { return !(*this == other); }
+};
 
-		glfwSetWindowUserPointer(window, this);
-		glfwSetWindowSizeCallback(window, WorkSpace::onWindowResized);
+//marks an unused entry of a chunk's slot table
+const uint16_t NO_SLOT_CELL = 0xFFFF;
+
+struct Chunk {
+	Chunk(int _x, int _y, int _z) { origin = glm::ivec3(_x, _y, _z) * CHUNK_SIZE; }
+	//position of the chunk's lowest corner in block coordinates
+	glm::ivec3 origin;
+	int blockCount = 0;
+	std::bitset<CHUNK_VOLUME> occupied;
+	std::array<uint8_t, CHUNK_VOLUME> cells;
+	//open addressing table from each occupied cell to the slot of its block, so a position can be turned into a handle
+	//it is sized to the occupied cells rather than the whole chunk, unused entries hold NO_SLOT_CELL
+	std::vector<uint16_t> slotCells;
+	std::vector<uint32_t> slotIndices;
+	//which of the six neighbours of each occupied cell hold a block, bit n is set for the neighbour in blockDirection n
+	std::array<uint8_t, CHUNK_VOLUME> neighbours;
+
+	//slot of the block in an occupied cell
+	uint32_t getSlot(int cell) const {
+		return slotIndices[findSlotEntry(cell)];
+	}
+	//called before blockCount counts the new cell
+	void insertSlot(int cell, uint32_t slot) {
+		//kept at most three quarters full so probes stay short
+		if ((size_t)(blockCount + 1) * 4 > slotCells.size() * 3) {
+			resizeSlots(std::max<size_t>(slotCells.size() * 2, 16));
+		}
+		size_t mask = slotCells.size() - 1;
+		size_t entry = getSlotHome(cell);
+		while (slotCells[entry] != NO_SLOT_CELL) {
+			entry = (entry + 1) & mask;
+		}
+		slotCells[entry] = (uint16_t)cell;
+		slotIndices[entry] = slot;
+	}
+	void eraseSlot(int cell) {
+		//later entries of the probe run are moved back into the hole so lookups never need tombstones
+		size_t mask = slotCells.size() - 1;
+		size_t hole = findSlotEntry(cell);
+		for (size_t entry = (hole + 1) & mask; slotCells[entry] != NO_SLOT_CELL; entry = (entry + 1) & mask) {
+			if (((entry - getSlotHome(slotCells[entry])) & mask) >= ((entry - hole) & mask)) {
+				slotCells[hole] = slotCells[entry];
+				slotIndices[hole] = slotIndices[entry];
+				hole = entry;
+			}
+		}
+		slotCells[hole] = NO_SLOT_CELL;
 	}
-
-	static void onWindowResized(GLFWwindow* window, int width, int height) {
-		if (width == 0 || height == 0) return;
-
-		WorkSpace* app = reinterpret_cast<WorkSpace*>(glfwGetWindowUserPointer(window));
-		app->recreateSwapChain();
+	size_t getSlotTableBytes() const {
+		return slotCells.capacity() * sizeof(uint16_t) + slotIndices.capacity() * sizeof(uint32_t);
 	}
-	int x = 0;
-	int y = 0;
-
-	std::vector<Vertex> verticesInverterModel;
-	std::vector<uint32_t> indicesInverterModel;
-
-	std::vector<Vertex> verticesModelRotated;
-
-	//initialises vulkan
-	void initVulkan() {
-		
-		createInstance();
-		setupDebugCallback();
-		createSurface();
-		pickPhysicalDevice();
-		createLogicalDevice();
-		createSwapChain();
-		createImageViews();
-		createRenderPass();
-		createDescriptorSetLayout();
-		createGraphicsPipeline();
-		createCommandPool();
-		createDepthResources();
-		createFramebuffers();
-		createTextureImage();
-		createTextureImageView();
-		createTextureSampler();
-		
-		loadModel(&verticesInverterModel, &indicesInverterModel, "models/xyzOrigin.obj", glm::vec3(0.1, 0.9, 0.1));
-		loadPrimitive("andGate", "models/AndGate.obj", glm::vec3(0.5, 0.5, 0.9));
-		loadPrimitive("xorGate", "models/XorGate.obj", glm::vec3(0.5, 0.5, 0.9));
-		loadPrimitive("orGate", "models/OrGate.obj", glm::vec3(0.5, 0.5, 0.9));
-		loadPrimitive("wire", "models/wire2.obj", glm::vec3(0.9, 0.1, 0.1));
-		loadPrimitive("wire_center", "models/wire_center.obj", glm::vec3(0.7, 0.1, 0.1));
-		loadPrimitive("inverter", "models/inverter.obj", glm::vec3(0.1, 0.1, 0.9));
-
-		Vertex temp = {};
-		temp.texCoord = { 0, 0 };
-		temp.pos = { 1, 1, 1 };
-		temp.color = { 1, 0, 1 };
-		vertices.push_back(temp);
-		temp.texCoord = { 0, 0 };
-		temp.pos = { 5, 1, 1 };
-		temp.color = { 1, 0, 0 };
-		vertices.push_back(temp);
-		temp.texCoord = { 0, 0 };
-		temp.pos = { 1, 5, 1 };
-		temp.color = { 1, 1, 1 };
-		vertices.push_back(temp);
-		indices.push_back(vertices.size() - 3);
-		indices.push_back(vertices.size() - 2);
-		indices.push_back(vertices.size() - 1);
-		//for (int i = 0; i < 500; i++) {
-			//addVectors(&vertices, &indices, &verticesInverterModel, &indicesInverterModel);
-		//}
-
-		createVertexBuffer(vertices, vertexBuffer, vertexBufferMemory);
-		createIndexBuffer(indices, indexBuffer, indexBufferMemory);
-		createUniformBuffer();
-		createDescriptorPool();
-		createDescriptorSet();
-		createCommandBuffers();
-		createSemaphores();
-
-
-
-
-
-		////////
-		///////////
-		//VkDevice* test;
-		//test = device.replace();
-		blocks.blocksDevice = device;
+	Block getBlock(int cell) const {
+		return Block(origin.x + (cell & CHUNK_MASK), origin.y + (cell >> (CHUNK_SHIFT * 2)), origin.z + ((cell >> CHUNK_SHIFT) & CHUNK_MASK), (blockType)(cells[cell] >> 3), (blockDirection)(cells[cell] & 7));
 	}
-	bool drawBoxes = false;
-	void drawBlocks() {
-		glm::vec3 color;
-		std::vector<Vertex> tempVertices;
-		std::vector<uint32_t> tempIndices;
-		for (int i = 0; i < blocks.blocks.size(); i++) {
-			tempVertices.clear();
-			tempIndices.clear();
-			bool x = false;
-			bool y = false;
-			bool z = false;
-			switch (blocks.blocks[i].type) {
-			case wire:
-				color = glm::vec3(0.6, 0, 0);
-
-
-
-				//bottom Y front
-				if (blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y - 1, blocks.blocks[i].position.z)) {
-					addPrimitive("wire", blocks.blocks[i].position, NY, &tempVertices, &tempIndices);
-					y = true;
-				}
-				//top Y back
-				if (blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y + 1, blocks.blocks[i].position.z)) {
-					addPrimitive("wire", blocks.blocks[i].position, PY, &tempVertices, &tempIndices);
-					y = true;
-				}
-				//Z front
-				if (blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y, blocks.blocks[i].position.z - 1)) {
-					addPrimitive("wire", blocks.blocks[i].position, NZ, &tempVertices, &tempIndices);
-					z = true;
-				}
-				//Z back
-				if (blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y, blocks.blocks[i].position.z + 1)) {
-					addPrimitive("wire", blocks.blocks[i].position, PZ, &tempVertices, &tempIndices);
-					z = true;
-				}
-				//X front
-				if (blocks.doesBlockExist(blocks.blocks[i].position.x - 1, blocks.blocks[i].position.y, blocks.blocks[i].position.z)) {
-					addPrimitive("wire", blocks.blocks[i].position, NX, &tempVertices, &tempIndices);
-					x = true;
-				}
-				//X back
-				if (blocks.doesBlockExist(blocks.blocks[i].position.x + 1, blocks.blocks[i].position.y, blocks.blocks[i].position.z)) {
-					addPrimitive("wire", blocks.blocks[i].position, PX, &tempVertices, &tempIndices);
-					x = true;
-				}
-				if ( !x && !y && !z) {
-					addPrimitive("wire_center", blocks.blocks[i].position, &tempVertices, &tempIndices);
-				}
-				//addPrimitive("wire", blocks.blocks[i].position);
-				break;
-			case inverter:
-				switch (blocks.blocks[i].direction) {
-				case positiveX:
-					addPrimitive("inverter", blocks.blocks[i].position, NX, &tempVertices, &tempIndices);
-					break;
-				case negativeX:
-					addPrimitive("inverter", blocks.blocks[i].position, PX, &tempVertices, &tempIndices);
-					break;
-				case positiveY:
-					addPrimitive("inverter", blocks.blocks[i].position, NY, &tempVertices, &tempIndices);
-					break;
-				case negativeY:
-					addPrimitive("inverter", blocks.blocks[i].position, PY, &tempVertices, &tempIndices);
-					break;
-				case positiveZ:
-					addPrimitive("inverter", blocks.blocks[i].position, NZ, &tempVertices, &tempIndices);
-					break;
-				case negativeZ:
-					addPrimitive("inverter", blocks.blocks[i].position, PZ, &tempVertices, &tempIndices);
-					break;
-
-				}
-				break;
-			case andGate:
-				switch (blocks.blocks[i].direction) {
-				case positiveX:
-					addPrimitive("andGate", blocks.blocks[i].position, NX, &tempVertices, &tempIndices);
-					break;
-				case negativeX:
-					addPrimitive("andGate", blocks.blocks[i].position, PX, &tempVertices, &tempIndices);
-					break;
-				case positiveY:
-					addPrimitive("andGate", blocks.blocks[i].position, NY, &tempVertices, &tempIndices);
-					break;
-				case negativeY:
-					addPrimitive("andGate", blocks.blocks[i].position, PY, &tempVertices, &tempIndices);
-					break;
-				case positiveZ:
-					addPrimitive("andGate", blocks.blocks[i].position, NZ, &tempVertices, &tempIndices);
-					break;
-				case negativeZ:
-					addPrimitive("andGate", blocks.blocks[i].position, PZ, &tempVertices, &tempIndices);
-					break;
-
-				}
-				color = glm::vec3(0, 0, 0.8);
-				break;
-			case orGate:
-				switch (blocks.blocks[i].direction) {
-				case positiveX:
-					addPrimitive("orGate", blocks.blocks[i].position, NX, &tempVertices, &tempIndices);
-					break;
-				case negativeX:
-					addPrimitive("orGate", blocks.blocks[i].position, PX, &tempVertices, &tempIndices);
-					break;
-				case positiveY:
-					addPrimitive("orGate", blocks.blocks[i].position, NY, &tempVertices, &tempIndices);
-					break;
-				case negativeY:
-					addPrimitive("orGate", blocks.blocks[i].position, PY, &tempVertices, &tempIndices);
-					break;
-				case positiveZ:
-					addPrimitive("orGate", blocks.blocks[i].position, NZ, &tempVertices, &tempIndices);
-					break;
-				case negativeZ:
-					addPrimitive("orGate", blocks.blocks[i].position, PZ, &tempVertices, &tempIndices);
-					break;
-
-				}
-				color = glm::vec3(0, 0, 0.8);
-				break;
-			case xorGate:
-				switch (blocks.blocks[i].direction) {
-				case positiveX:
-					addPrimitive("xorGate", blocks.blocks[i].position, NX, &tempVertices, &tempIndices);
-					break;
-				case negativeX:
-					addPrimitive("xorGate", blocks.blocks[i].position, PX, &tempVertices, &tempIndices);
-					break;
-				case positiveY:
-					addPrimitive("xorGate", blocks.blocks[i].position, NY, &tempVertices, &tempIndices);
-					break;
-				case negativeY:
-					addPrimitive("xorGate", blocks.blocks[i].position, PY, &tempVertices, &tempIndices);
-					break;
-				case positiveZ:
-					addPrimitive("xorGate", blocks.blocks[i].position, NZ, &tempVertices, &tempIndices);
-					break;
-				case negativeZ:
-					addPrimitive("xorGate", blocks.blocks[i].position, PZ, &tempVertices, &tempIndices);
-					break;
 
+private:
+	//cells are scattered over the table with a multiplicative hash, the table size is always a power of two
+	size_t getSlotHome(int cell) const {
+		return ((uint32_t)cell * 2654435761u >> 16) & (slotCells.size() - 1);
+	}
+	//the cell must be occupied
+	size_t findSlotEntry(int cell) const {
+		size_t mask = slotCells.size() - 1;
+		size_t entry = getSlotHome(cell);
+		while (slotCells[entry] != cell) {
+			entry = (entry + 1) & mask;
+		}
+		return entry;
+	}
+	void resizeSlots(size_t size) {
+		std::vector<uint16_t> oldCells(size, NO_SLOT_CELL);
+		std::vector<uint32_t> oldIndices(size);
+		oldCells.swap(slotCells);
+		oldIndices.swap(slotIndices);
+		size_t mask = size - 1;
+		for (size_t i = 0; i < oldCells.size(); i++) {
+			if (oldCells[i] != NO_SLOT_CELL) {
+				size_t entry = getSlotHome(oldCells[i]);
+				while (slotCells[entry] != NO_SLOT_CELL) {
+					entry = (entry + 1) & mask;
 				}
-				color = glm::vec3(0, 0, 0.8);
-				break;
+				slotCells[entry] = oldCells[i];
+				slotIndices[entry] = oldIndices[i];
 			}
-			/*
-			if (blocks[i].type == wire) {
-			addVectorsWithOffset()
-			}
-			*/
-			//DO THIS WITH 8 VERTICES
-			//HAVE IFS FOR ADDING INDICES
-
-			/*if (drawBoxes) {
-
-				//ADDING VERTICES:
-				Vertex temp = {};
-				temp.texCoord = { 0, 0 };
-				temp.color = { color.r + 0.3, color.g + 0.3, color.b + 0.3 };
-				temp.pos = blocks.blocks[i].position + glm::vec3(0, 0, 0);
-				vertices.push_back(temp);
-				temp.color = { color.r, color.g, color.b };
-				temp.pos = blocks.blocks[i].position + glm::vec3(1, 0, 0); //
-				vertices.push_back(temp);
-				temp.pos = blocks.blocks[i].position + glm::vec3(1, 0, 1); //
-				vertices.push_back(temp);
-				temp.pos = blocks.blocks[i].position + glm::vec3(0, 0, 1);
-				vertices.push_back(temp);
-				temp.pos = blocks.blocks[i].position + glm::vec3(0, 1, 0);
-				vertices.push_back(temp);
-				temp.pos = blocks.blocks[i].position + glm::vec3(1, 1, 0); //
-				vertices.push_back(temp);
-				temp.color = { color.r - 0.3, color.g - 0.3, color.b - 0.3 };
-				temp.pos = blocks.blocks[i].position + glm::vec3(1, 1, 1); //
-
-				vertices.push_back(temp);
-				temp.color = { color.r, color.g, color.b };
-				temp.pos = blocks.blocks[i].position + glm::vec3(0, 1, 1);
-				vertices.push_back(temp);
-
-				//ADDING INDICES:
-				//bottom Y front
-				if (!blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y - 1, blocks.blocks[i].position.z)) {
-					addFace(vertices.size() - 8, vertices.size() - 7, vertices.size() - 6, vertices.size() - 5);
-				}
-				//top Y back
-				if (!blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y + 1, blocks.blocks[i].position.z)) {
-					addFace(vertices.size() - 1, vertices.size() - 2, vertices.size() - 3, vertices.size() - 4);
-				}
-				//Z back
-				if (!blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y, blocks.blocks[i].position.z + 1)) {
-					addFace(vertices.size() - 5, vertices.size() - 6, vertices.size() - 2, vertices.size() - 1);
-				}
-				//Z front
-				if (!blocks.doesBlockExist(blocks.blocks[i].position.x, blocks.blocks[i].position.y, blocks.blocks[i].position.z - 1)) {
-					addFace(vertices.size() - 4, vertices.size() - 3, vertices.size() - 7, vertices.size() - 8);
-				}
-				//X front
-				if (!blocks.doesBlockExist(blocks.blocks[i].position.x - 1, blocks.blocks[i].position.y, blocks.blocks[i].position.z)) {
-					addFace(vertices.size() - 8, vertices.size() - 5, vertices.size() - 1, vertices.size() - 4);
-				}
-				//X back
-				if (!blocks.doesBlockExist(blocks.blocks[i].position.x + 1, blocks.blocks[i].position.y, blocks.blocks[i].position.z)) {
-					addFace(vertices.size() - 3, vertices.size() - 2, vertices.size() - 6, vertices.size() - 7);
-				}
-			}*/
-			createVertexBuffer(tempVertices, blocks.blocks[i].vertexBuffer, blocks.blocks[i].vertexBufferMemory);
-			createIndexBuffer(tempIndices, blocks.blocks[i].indexBuffer, blocks.blocks[i].indexBufferMemory);
 		}
 	}
+};
 
-	void addFace(int p1, int p2, int p3, int p4) {
-		indices.push_back(p1);
-		indices.push_back(p2);
-		indices.push_back(p3);
-		indices.push_back(p1);
-		indices.push_back(p3);
-		indices.push_back(p4);
+//an immutable view of the world at one version for worker threads, chunks are shared with the live world until it edits them
+//the chunks of an old version are freed once the last reader lets go of its snapshot
+struct BlockSnapshot {
+	uint64_t version = 0;
+	int blockCount = 0;
+	std::unordered_map<uint64_t, std::shared_ptr<const Chunk>> chunks;
+
+	bool doesBlockExist(int x, int y, int z) const {
+		auto it = chunks.find(packBlockPosition(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT));
+		return it != chunks.end() && it->second->occupied[chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK)];
+	}
+	bool getBlock(int x, int y, int z, Block* block) const {
+		auto it = chunks.find(packBlockPosition(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT));
+		if (it == chunks.end()) {
+			return false;
+		}
+		int cell = chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+		if (!it->second->occupied[cell]) {
+			return false;
+		}
+		*block = it->second->getBlock(cell);
+		return true;
 	}
+	uint8_t getNeighbours(int x, int y, int z) const {
+		auto it = chunks.find(packBlockPosition(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT));
+		if (it == chunks.end()) {
+			return 0;
+		}
+		int cell = chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+		return it->second->occupied[cell] ? it->second->neighbours[cell] : 0;
+	}
+};
 
-
-
-	void addVectors(std::vector<Vertex>* originalVertices, std::vector<uint32_t>* originalIndices, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices) {
-		int temp = originalVertices->size();
-		for (int i = 0; i < vertices->size(); i++) {
-			originalVertices->push_back(vertices->at(i));
+//a copied box of blocks, one packed cell per position with x changing fastest then z then y like chunk cells
+const uint8_t EMPTY_CELL = 0xFF;
+struct BlockClipboard {
+	glm::ivec3 size = glm::ivec3(0, 0, 0);
+	std::vector<uint8_t> cells;
+
+	int getIndex(int x, int y, int z) const {
+		return x + (z + y * size.z) * size.x;
+	}
+	glm::ivec3 getRotatedSize(int quarterTurns) const {
+		return (quarterTurns & 1) ? glm::ivec3(size.z, size.y, size.x) : size;
+	}
+	//reads the cell that lands on (x, y, z) once the clipboard is turned quarterTurns times around y, the direction is turned with it
+	uint8_t getRotated(int x, int y, int z, int quarterTurns) const {
+		int sourceX = x;
+		int sourceZ = z;
+		//each turn maps (x, z) to (width - 1 - z, x) where width is the z size before the turn, so undo the turns one at a time from the last
+		for (int turn = quarterTurns; turn > 0; turn--) {
+			int width = (turn & 1) ? size.z : size.x;
+			int temp = sourceX;
+			sourceX = sourceZ;
+			sourceZ = width - 1 - temp;
 		}
-		for (int i = 0; i < indices->size(); i++) {
-			originalIndices->push_back(indices->at(i) + temp);
+		uint8_t packed = cells[getIndex(sourceX, y, sourceZ)];
+		if (packed == EMPTY_CELL) {
+			return packed;
 		}
+		//+x -> +z -> -x -> -z -> +x, y directions are left alone
+		static const blockDirection turned[6] = { positiveZ, negativeZ, positiveY, negativeY, negativeX, positiveX };
+		blockDirection direction = (blockDirection)(packed & 7);
+		for (int i = 0; i < quarterTurns; i++) {
+			direction = turned[direction];
+		}
+		return packBlock((blockType)(packed >> 3), direction);
 	}
-	enum orientation {PX, NX, PY, NY, PZ, NZ};
-	void addPrimitive(std::string name, glm::vec3 offset, orientation _orientation, std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
-		
-		
+};
 
-		for (int i = 0; i < primitives.size(); i++) {
-			if (primitives[i].name == name) {
-			std::vector<Vertex>* vector =&primitives[i].verticesPX;
-			switch (_orientation) {
-			case PX:
-				vector = &primitives[i].verticesPX;
-				break;
-			case NX:
-				vector = &primitives[i].verticesNX;
-				break;
-			case PY:
-				vector = &primitives[i].verticesPY;
-				break;
-			case NY:
-				vector = &primitives[i].verticesNY;
-				break;
-			case PZ:
-				vector = &primitives[i].verticesPZ;
-				break;
-			case NZ:
-				vector = &primitives[i].verticesNZ;
-				break;
-			}
-				addVectorsWithOffset(_vertices, _indices, vector, &primitives[i].indices, offset);
+class Blocks {
+public:
+	Blocks() {}
+
+	//only blocks around the camera can be hit, so only those cells are checked instead of every block in the world
+	void correctCameraWithBlocks(glm::vec3* cameraMin, glm::vec3* cameraMax, glm::vec3* cameraVel) {
+		glm::ivec3 min = glm::floor(glm::min(*cameraMin, *cameraMin + *cameraVel)) - glm::vec3(1, 1, 1);
+		glm::ivec3 max = glm::floor(glm::max(*cameraMax, *cameraMax + *cameraVel)) + glm::vec3(1, 1, 1);
+		for (int x = min.x; x <= max.x; x++) {
+			for (int y = min.y; y <= max.y; y++) {
+				for (int z = min.z; z <= max.z; z++) {
+					if (doesBlockExist(x, y, z)) {
+						glm::vec3 blockMin = glm::vec3(x, y, z);
+						glm::vec3 blockMax = glm::vec3(x + 1, y + 1, z + 1);
+						correctBoundingBox(cameraMin, cameraMax, &blockMin, &blockMax, cameraVel);
+					}
+				}
 			}
 		}
 	}
-	void addPrimitive(std::string name, glm::vec3 offset, std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
-		for (int i = 0; i < primitives.size(); i++) {
-			if (primitives[i].name == name) {
-				addVectorsWithOffset(_vertices, _indices, &primitives[i].verticesPX, &primitives[i].indices, offset);
-			}
+	void init(std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
+		vertices = _vertices;
+		indices = _indices;
+		//for (int i = 0; i < 200; i++) {
+			addBlock(((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120, inverter);
+		//}
+		/*
+		for (int i = 0; i < 25600; i++) {
+			addBlock(((double)rand() / (RAND_MAX)) * 400 - 600, ((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400);
+		}
+
+		for (int i = 0; i < 25600; i++) {
+			addBlock(((double)rand() / (RAND_MAX)) * 400 -600, ((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400 - 600);
 		}
+
+		for (int i = 0; i < 25600; i++) {
+			addBlock(((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400, ((double)rand() / (RAND_MAX)) * 400 - 600);
+		}*/
 	}
 
-	 void loadPrimitive(std::string name, std::string path, glm::vec3 colour) {
-		primitive temp;
-		loadModel(&temp.verticesPX, &temp.indices, path, colour);
-		temp.name = name;
-		temp = rotatePrimitive(temp);
-		primitives.push_back(temp);
+	BlockHandle addBlock(int x, int y, int z, blockType type) {
+		return addBlock(x, y, z, type, positiveY);
 	}
-	 primitive rotatePrimitive(primitive _primitive) {
-		 float PI = 3.1415926;
-		 float angle = PI;
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesPX[i].pos -= glm::vec3(0.5, 0.5, 0.5);
-		 }
-		 _primitive.verticesNX = _primitive.verticesPX;
-		 _primitive.verticesNY = _primitive.verticesPX;
-		 _primitive.verticesPY = _primitive.verticesPX;
-		 _primitive.verticesNZ = _primitive.verticesPX;
-		 _primitive.verticesPZ = _primitive.verticesPX;
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesNX[i].pos = glm::rotateY(_primitive.verticesPX[i].pos, angle);
-			 _primitive.verticesNX[i].pos += glm::vec3(0.5, 0.5, 0.5);
-		 }
- 		 angle = PI * 1.5;
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesPZ[i].pos = glm::rotateY(_primitive.verticesPX[i].pos, angle);
-			 _primitive.verticesPZ[i].pos += glm::vec3(0.5, 0.5, 0.5);
-		 }
-		 angle = PI / 2;
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesNZ[i].pos = glm::rotateY(_primitive.verticesPX[i].pos, angle);
-			 _primitive.verticesNZ[i].pos += glm::vec3(0.5, 0.5, 0.5);
-		 }
-		 angle = PI/2;
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesPY[i].pos = glm::rotateZ(_primitive.verticesPX[i].pos, angle);
-			 _primitive.verticesPY[i].pos += glm::vec3(0.5, 0.5, 0.5);
-		 }
-		 angle = PI * 1.5;
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesNY[i].pos = glm::rotateZ(_primitive.verticesPX[i].pos, angle);
-			 _primitive.verticesNY[i].pos += glm::vec3(0.5, 0.5, 0.5);
-		 }
-		 for (int i = 0; i < _primitive.verticesPX.size(); i++) {
-			 _primitive.verticesPX[i].pos += glm::vec3(0.5, 0.5, 0.5);
-		 }
-		 return _primitive;
+	//returns an invalid handle if the position is already taken
+	//checked before the chunk is made writable, so a refused add doesn't copy the chunk, bump the version or queue a remesh
+	BlockHandle addBlock(int x, int y, int z, blockType type, blockDirection direction) {
+		if (doesBlockExist(x, y, z)) {
+			return BlockHandle();
+		}
+		Chunk& chunk = getChunk(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+		return insertBlock(chunk, chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK), packBlock(type, direction));
 	}
-	void loadModel(std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices, std::string path, glm::vec3 colour) {
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string err;
-
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str())) {
-			throw std::runtime_error(err);
+	int getVectorSize() {
+		return blockCount;
+	}
+	//every live block packed together with no holes, the order changes when blocks are removed
+	const std::vector<Block>& getBlocks() const {
+		return denseBlocks;
+	}
+	//reorders the dense blocks along the z-order curve so walking them visits neighbouring blocks together
+	//handles stay valid, only the dense order changes, adds and removes afterwards break the order again until the next sort
+	void sortBlocks() {
+		std::vector<std::pair<uint64_t, uint32_t>> order(denseBlocks.size());
+		for (uint32_t i = 0; i < denseBlocks.size(); i++) {
+			order[i] = std::make_pair(mortonCode(denseBlocks[i].position.x, denseBlocks[i].position.y, denseBlocks[i].position.z), i);
 		}
-
-		std::unordered_map<Vertex, int> uniqueVertices = {};
-
-		for (const auto& shape : shapes) {
-			for (const auto& index : shape.mesh.indices) {
-				Vertex vertex = {};
-
-				vertex.pos = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				};
-
-				vertex.texCoord = {0,0};// {attrib.texcoords[2 * index.texcoord_index + 0],1.0f - attrib.texcoords[2 * index.texcoord_index + 1]};
-
-				vertex.color = { colour.r -0.2 + 0.4*((double)rand() / (RAND_MAX)), colour.g - 0.2 + 0.4*((double)rand() / (RAND_MAX)), colour.b - 0.2 + 0.4*((double)rand() / (RAND_MAX)) };
-
-				if (uniqueVertices.count(vertex) == 0) {
-					uniqueVertices[vertex] = _vertices->size();
-					_vertices->push_back(vertex);
-				}
-
-				_indices->push_back(uniqueVertices[vertex]);
+		//lsd radix sort a byte at a time, bytes that are the same in every key (the high ones in any normal sized world) are skipped
+		std::vector<std::pair<uint64_t, uint32_t>> sortedOrder(order.size());
+		for (int shift = 0; shift < 64; shift += 8) {
+			size_t offsets[257] = {};
+			for (size_t i = 0; i < order.size(); i++) {
+				offsets[((order[i].first >> shift) & 0xFF) + 1]++;
+			}
+			if (order.empty() || offsets[((order[0].first >> shift) & 0xFF) + 1] == order.size()) {
+				continue;
 			}
+			for (int digit = 0; digit < 256; digit++) {
+				offsets[digit + 1] += offsets[digit];
+			}
+			for (size_t i = 0; i < order.size(); i++) {
+				sortedOrder[offsets[(order[i].first >> shift) & 0xFF]++] = order[i];
+			}
+			order.swap(sortedOrder);
 		}
 
+		std::vector<Block> sortedBlocks(denseBlocks.size());
+		std::vector<uint32_t> sortedToSlot(denseBlocks.size());
+		for (uint32_t i = 0; i < order.size(); i++) {
+			sortedBlocks[i] = denseBlocks[order[i].second];
+			sortedToSlot[i] = denseToSlot[order[i].second];
+			slots[sortedToSlot[i]].dense = i;
+		}
+		denseBlocks.swap(sortedBlocks);
+		denseToSlot.swap(sortedToSlot);
+	}
+	//when set, every region edit re-sorts the dense blocks once it's done, single block edits never do
+	bool keepSorted = false;
+	bool isValid(BlockHandle handle) const {
+		return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+	}
+	//the last block in the dense array is moved into the hole so removal never shifts the rest of the blocks
+	bool removeBlock(BlockHandle handle) {
+		if (!isValid(handle)) {
+			return false;
+		}
+		glm::ivec3 position = denseBlocks[slots[handle.index].dense].position;
+		auto it = chunks.find(packBlockPosition(position.x >> CHUNK_SHIFT, position.y >> CHUNK_SHIFT, position.z >> CHUNK_SHIFT));
+		Chunk& chunk = getWritableChunk(it->second);
+		eraseBlock(chunk, chunkCell(position.x & CHUNK_MASK, position.y & CHUNK_MASK, position.z & CHUNK_MASK));
+		//empty chunks are dropped so memory stays proportional to the chunks that hold blocks
+		if (chunk.blockCount == 0) {
+			eraseChunk(it);
+		}
+		return true;
 	}
-
-	void createDepthResources() {
-		VkFormat depthFormat = findDepthFormat();
-
-		createImage(swapChainExtent.width, swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
-		createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, depthImageView);
-
-		transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	bool removeBlock(int x, int y, int z) {
+		return removeBlock(getBlock(x, y, z));
 	}
-
-	VkFormat findDepthFormat() {
-		return findSupportedFormat(
-		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
-			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
-		);
+	//bit n is set when the neighbour in blockDirection n holds a block, 0 if there is no block at the position
+	uint8_t getNeighbours(int x, int y, int z) {
+		auto it = chunks.find(packBlockPosition(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT));
+		if (it == chunks.end()) {
+			return 0;
+		}
+		int cell = chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+		return it->second->occupied[cell] ? it->second->neighbours[cell] : 0;
+	}
+	bool doesBlockExist(int x, int y, int z) {
+		auto it = chunks.find(packBlockPosition(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT));
+		return it != chunks.end() && it->second->occupied[chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK)];
+	}
+	//returns an invalid handle if there is no block at the position
+	BlockHandle getBlock(int x, int y, int z) {
+		BlockHandle handle;
+		auto it = chunks.find(packBlockPosition(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT));
+		if (it == chunks.end()) {
+			return handle;
+		}
+		int cell = chunkCell(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+		if (!it->second->occupied[cell]) {
+			return handle;
+		}
+		handle.index = it->second->getSlot(cell);
+		handle.generation = slots[handle.index].generation;
+		return handle;
+	}
+	bool getBlock(int x, int y, int z, Block* block) {
+		return getBlock(getBlock(x, y, z), block);
+	}
+	bool getBlock(BlockHandle handle, Block* block) const {
+		if (!isValid(handle)) {
+			return false;
+		}
+		*block = denseBlocks[slots[handle.index].dense];
+		return true;
 	}
 
-	VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
-		for (VkFormat format : candidates) {
-			VkFormatProperties props;
-			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
-
-			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
-				return format;
+	//region edits take an inclusive box and walk it one chunk at a time, so each chunk is looked up once instead of once per block
+	//they return how many blocks changed, the caller only needs to remesh once afterwards
+	int fillRegion(glm::ivec3 min, glm::ivec3 max, blockType type, blockDirection direction) {
+		uint8_t packed = packBlock(type, direction);
+		int changed = 0;
+		forEachChunkInRegion(min, max, createChunks, [&](Chunk& chunk, glm::ivec3 localMin, glm::ivec3 localMax) {
+			for (int y = localMin.y; y <= localMax.y; y++) {
+				for (int z = localMin.z; z <= localMax.z; z++) {
+					for (int x = localMin.x; x <= localMax.x; x++) {
+						int cell = chunkCell(x, y, z);
+						if (!chunk.occupied[cell]) {
+							insertBlock(chunk, cell, packed);
+							changed++;
+						}
+						else if (chunk.cells[cell] != packed) {
+							setBlock(chunk, cell, packed);
+							changed++;
+						}
+					}
+				}
 			}
-			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
-				return format;
+		});
+		if (keepSorted && changed > 0) {
+			sortBlocks();
+		}
+		return changed;
+	}
+	int clearRegion(glm::ivec3 min, glm::ivec3 max) {
+		int changed = 0;
+		//chunks are only made writable when the box holds one of their blocks, so empty overlaps aren't copied or remeshed
+		forEachChunkInRegion(min, max, readChunks, [&](Chunk& readChunk, glm::ivec3 localMin, glm::ivec3 localMax) {
+			bool found = false;
+			for (int y = localMin.y; y <= localMax.y && !found; y++) {
+				for (int z = localMin.z; z <= localMax.z && !found; z++) {
+					for (int x = localMin.x; x <= localMax.x && !found; x++) {
+						found = readChunk.occupied[chunkCell(x, y, z)];
+					}
+				}
+			}
+			if (!found) {
+				return;
 			}
+			glm::ivec3 chunkPosition = readChunk.origin >> CHUNK_SHIFT;
+			Chunk& chunk = getWritableChunk(chunks.find(packBlockPosition(chunkPosition.x, chunkPosition.y, chunkPosition.z))->second);
+			for (int y = localMin.y; y <= localMax.y; y++) {
+				for (int z = localMin.z; z <= localMax.z; z++) {
+					for (int x = localMin.x; x <= localMax.x; x++) {
+						int cell = chunkCell(x, y, z);
+						if (chunk.occupied[cell]) {
+							eraseBlock(chunk, cell);
+							changed++;
+						}
+					}
+				}
+			}
+		});
+		removeEmptyChunks(min, max);
+		if (keepSorted && changed > 0) {
+			sortBlocks();
 		}
-
-		throw std::runtime_error("failed to find supported format!");
-	}
-
-	void createTextureSampler() {
-		VkSamplerCreateInfo samplerInfo = {};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = 16;
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
-		samplerInfo.compareEnable = VK_FALSE;
-		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;
-		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
-		if (vkCreateSampler(device, &samplerInfo, nullptr, textureSampler.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create texture sampler!");
+		return changed;
+	}
+	//copies the box into the clipboard, cells without a block are stored as EMPTY_CELL
+	void copyRegion(glm::ivec3 min, glm::ivec3 max, BlockClipboard* clipboard) {
+		clipboard->size = max - min + glm::ivec3(1, 1, 1);
+		clipboard->cells.assign(clipboard->size.x * clipboard->size.y * clipboard->size.z, EMPTY_CELL);
+		forEachChunkInRegion(min, max, readChunks, [&](const Chunk& chunk, glm::ivec3 localMin, glm::ivec3 localMax) {
+			for (int y = localMin.y; y <= localMax.y; y++) {
+				for (int z = localMin.z; z <= localMax.z; z++) {
+					for (int x = localMin.x; x <= localMax.x; x++) {
+						int cell = chunkCell(x, y, z);
+						if (chunk.occupied[cell]) {
+							glm::ivec3 offset = chunk.origin + glm::ivec3(x, y, z) - min;
+							clipboard->cells[clipboard->getIndex(offset.x, offset.y, offset.z)] = chunk.cells[cell];
+						}
+					}
+				}
+			}
+		});
+	}
+	//stamps the clipboard with its lowest corner at origin after turning it quarterTurns times around the y axis
+	//only the clipboard's blocks are written, empty clipboard cells leave the world alone
+	int pasteRegion(const BlockClipboard& clipboard, glm::ivec3 origin, int quarterTurns) {
+		quarterTurns &= 3;
+		glm::ivec3 size = clipboard.getRotatedSize(quarterTurns);
+		int changed = 0;
+		forEachChunkInRegion(origin, origin + size - glm::ivec3(1, 1, 1), createChunks, [&](Chunk& chunk, glm::ivec3 localMin, glm::ivec3 localMax) {
+			for (int y = localMin.y; y <= localMax.y; y++) {
+				for (int z = localMin.z; z <= localMax.z; z++) {
+					for (int x = localMin.x; x <= localMax.x; x++) {
+						glm::ivec3 offset = chunk.origin + glm::ivec3(x, y, z) - origin;
+						uint8_t packed = clipboard.getRotated(offset.x, offset.y, offset.z, quarterTurns);
+						if (packed == EMPTY_CELL) {
+							continue;
+						}
+						int cell = chunkCell(x, y, z);
+						if (!chunk.occupied[cell]) {
+							insertBlock(chunk, cell, packed);
+							changed++;
+						}
+						else if (chunk.cells[cell] != packed) {
+							setBlock(chunk, cell, packed);
+							changed++;
+						}
+					}
+				}
+			}
+		});
+		//a paste made only of empty cells can leave newly created chunks empty
+		removeEmptyChunks(origin, origin + size - glm::ivec3(1, 1, 1));
+		if (keepSorted && changed > 0) {
+			sortBlocks();
+		}
+		return changed;
+	}
+	//appends every block inside the inclusive box to found
+	void getBlocksInRegion(glm::ivec3 min, glm::ivec3 max, std::vector<Block>* found) {
+		forEachChunkInRegion(min, max, readChunks, [&](const Chunk& chunk, glm::ivec3 localMin, glm::ivec3 localMax) {
+			for (int y = localMin.y; y <= localMax.y; y++) {
+				for (int z = localMin.z; z <= localMax.z; z++) {
+					for (int x = localMin.x; x <= localMax.x; x++) {
+						int cell = chunkCell(x, y, z);
+						if (chunk.occupied[cell]) {
+							found->push_back(chunk.getBlock(cell));
+						}
+					}
+				}
+			}
+		});
+	}
+	//snapshots are taken on the main thread between edits, taking one only copies chunk pointers
+	//if nothing changed since the last snapshot that is still alive, that one is returned again
+	std::shared_ptr<const BlockSnapshot> getSnapshot() {
+		std::shared_ptr<const BlockSnapshot> snapshot = lastSnapshot.lock();
+		if (snapshot && snapshot->version == version) {
+			return snapshot;
+		}
+		std::shared_ptr<BlockSnapshot> created = std::make_shared<BlockSnapshot>();
+		created->version = version;
+		created->blockCount = blockCount;
+		created->chunks.reserve(chunks.size());
+		for (auto& chunkEntry : chunks) {
+			created->chunks.emplace(chunkEntry.first, chunkEntry.second);
+		}
+		lastSnapshot = created;
+		return created;
+	}
+	//makes the current version the one workers get from acquireSnapshot
+	void publishSnapshot() {
+		std::atomic_store(&publishedSnapshot, getSnapshot());
+	}
+	//safe to call from any thread, returns null until the first publishSnapshot
+	std::shared_ptr<const BlockSnapshot> acquireSnapshot() const {
+		return std::atomic_load(&publishedSnapshot);
+	}
+	//hands over the keys of every chunk changed since the last call (including chunks that were emptied and dropped) and clears them
+	//a chunk is also marked when an edit next to it changes its neighbour masks, since that changes its wires
+	void takeDirtyChunks(std::vector<uint64_t>* dirty) {
+		dirty->insert(dirty->end(), dirtyChunks.begin(), dirtyChunks.end());
+		dirtyChunks.clear();
+	}
+	//bumped by every edit, a snapshot with the same version matches the live world
+	uint64_t getVersion() const {
+		return version;
+	}
+	//how many chunks edits have had to copy because a snapshot still held them
+	uint64_t getChunksCopied() const {
+		return chunksCopied;
+	}
+	//smallest box of chunk coordinates holding every chunk, returns false if there are no chunks
+	bool getChunkBounds(glm::ivec3* min, glm::ivec3* max) {
+		if (chunks.empty()) {
+			return false;
+		}
+		if (chunkBoundsStale) {
+			chunkBoundsMin = chunkBoundsMax = chunks.begin()->second->origin >> CHUNK_SHIFT;
+			for (auto& chunkEntry : chunks) {
+				chunkBoundsMin = glm::min(chunkBoundsMin, chunkEntry.second->origin >> CHUNK_SHIFT);
+				chunkBoundsMax = glm::max(chunkBoundsMax, chunkEntry.second->origin >> CHUNK_SHIFT);
+			}
+			chunkBoundsStale = false;
 		}
+		*min = chunkBoundsMin;
+		*max = chunkBoundsMax;
+		return true;
 	}
-
-	void createTextureImageView() {
-		createImageView(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, textureImageView);
+	//approximate bytes used by the chunks and the slot map
+	size_t getMemoryUsage() const {
+		//each map node holds the key, the chunk pointer and a next pointer, plus one pointer per bucket, make_shared puts the chunk and its two counts together
+		size_t bytes = chunks.size() * (sizeof(uint64_t) + sizeof(std::shared_ptr<Chunk>) + sizeof(void*) + sizeof(Chunk) + 2 * sizeof(long)) + chunks.bucket_count() * sizeof(void*);
+		for (auto& chunkEntry : chunks) {
+			bytes += chunkEntry.second->getSlotTableBytes();
+		}
+		return bytes + denseBlocks.capacity() * sizeof(Block) + denseToSlot.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(BlockSlot);
 	}
-
-	void createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VDeleter<VkImageView>& imageView) {
-		VkImageViewCreateInfo viewInfo = {};
-		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewInfo.image = image;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = format;
-		viewInfo.subresourceRange.aspectMask = aspectFlags;
-		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
-		viewInfo.subresourceRange.layerCount = 1;
-
-		if (vkCreateImageView(device, &viewInfo, nullptr, imageView.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create texture image view!");
+	//chunk coordinate key -> chunk, chunks can be shared with snapshots so only read through this, edits go through getWritableChunk
+	std::unordered_map<uint64_t, std::shared_ptr<Chunk>> chunks;
+private:
+	//dense holds the block's index in denseBlocks while the slot is live and the next free slot while it is free
+	struct BlockSlot {
+		uint32_t generation = 0;
+		uint32_t dense = UINT32_MAX;
+	};
+	std::vector<Vertex>* vertices;
+	std::vector<uint32_t>* indices;
+	int blockCount = 0;
+	uint64_t version = 0;
+	uint64_t chunksCopied = 0;
+	std::unordered_set<uint64_t> dirtyChunks;
+	//kept up to date as chunks are created so nearest queries know how far out there can be blocks
+	glm::ivec3 chunkBoundsMin = glm::ivec3(0, 0, 0);
+	glm::ivec3 chunkBoundsMax = glm::ivec3(0, 0, 0);
+	bool chunkBoundsStale = false;
+	std::weak_ptr<const BlockSnapshot> lastSnapshot;
+	std::shared_ptr<const BlockSnapshot> publishedSnapshot;
+
+	//a chunk still held by a snapshot is copied before the first edit, the snapshot keeps the old copy
+	//every chunk handed out here is marked dirty so its mesh gets rebuilt
+	Chunk& getWritableChunk(std::shared_ptr<Chunk>& chunk) {
+		if (chunk.use_count() > 1) {
+			chunk = std::make_shared<Chunk>(*chunk);
+			chunksCopied++;
+		}
+		version++;
+		dirtyChunks.insert(packBlockPosition(chunk->origin.x >> CHUNK_SHIFT, chunk->origin.y >> CHUNK_SHIFT, chunk->origin.z >> CHUNK_SHIFT));
+		return *chunk;
+	}
+	//returns the chunk ready to edit, creating it if it's missing
+	Chunk& getChunk(int chunkX, int chunkY, int chunkZ) {
+		uint64_t key = packBlockPosition(chunkX, chunkY, chunkZ);
+		auto it = chunks.find(key);
+		if (it == chunks.end()) {
+			glm::ivec3 chunkPosition(chunkX, chunkY, chunkZ);
+			chunkBoundsMin = chunks.empty() ? chunkPosition : glm::min(chunkBoundsMin, chunkPosition);
+			chunkBoundsMax = chunks.empty() ? chunkPosition : glm::max(chunkBoundsMax, chunkPosition);
+			it = chunks.emplace(key, std::make_shared<Chunk>(chunkX, chunkY, chunkZ)).first;
 		}
+		return getWritableChunk(it->second);
 	}
-
-	void createTextureImage() {
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-		if (!pixels) {
-			throw std::runtime_error("failed to load texture image!");
+	//removing a chunk on the edge of the bounds only marks them stale, they are shrunk the next time they are asked for
+	void eraseChunk(std::unordered_map<uint64_t, std::shared_ptr<Chunk>>::iterator it) {
+		glm::ivec3 chunkPosition = it->second->origin >> CHUNK_SHIFT;
+		if (glm::any(glm::equal(chunkPosition, chunkBoundsMin)) || glm::any(glm::equal(chunkPosition, chunkBoundsMax))) {
+			chunkBoundsStale = true;
 		}
-
-		VDeleter<VkImage> stagingImage{ device, vkDestroyImage };
-		VDeleter<VkDeviceMemory> stagingImageMemory{ device, vkFreeMemory };
-		createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingImage, stagingImageMemory);
-
-		VkImageSubresource subresource = {};
-		subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresource.mipLevel = 0;
-		subresource.arrayLayer = 0;
-
-		VkSubresourceLayout stagingImageLayout;
-		vkGetImageSubresourceLayout(device, stagingImage, &subresource, &stagingImageLayout);
-
-		void* data;
-		vkMapMemory(device, stagingImageMemory, 0, imageSize, 0, &data);
-
-		if (stagingImageLayout.rowPitch == texWidth * 4) {
-			memcpy(data, pixels, (size_t)imageSize);
+		chunks.erase(it);
+	}
+	enum regionAccess { readChunks, writeChunks, createChunks };
+	//calls function(chunk, localMin, localMax) for every chunk the box touches with the part of the box inside that chunk
+	//missing chunks are only created for createChunks, chunks are only made writable (copied if a snapshot holds them) for writeChunks and createChunks
+	template<typename Function>
+	void forEachChunkInRegion(glm::ivec3 min, glm::ivec3 max, regionAccess access, Function function) {
+		glm::ivec3 low = glm::min(min, max);
+		glm::ivec3 high = glm::max(min, max);
+		for (int chunkX = low.x >> CHUNK_SHIFT; chunkX <= high.x >> CHUNK_SHIFT; chunkX++) {
+			for (int chunkY = low.y >> CHUNK_SHIFT; chunkY <= high.y >> CHUNK_SHIFT; chunkY++) {
+				for (int chunkZ = low.z >> CHUNK_SHIFT; chunkZ <= high.z >> CHUNK_SHIFT; chunkZ++) {
+					Chunk* chunk;
+					if (access == createChunks) {
+						chunk = &getChunk(chunkX, chunkY, chunkZ);
+					}
+					else {
+						auto it = chunks.find(packBlockPosition(chunkX, chunkY, chunkZ));
+						if (it == chunks.end()) {
+							continue;
+						}
+						chunk = access == writeChunks ? &getWritableChunk(it->second) : it->second.get();
+					}
+					glm::ivec3 localMin = glm::max(low - chunk->origin, glm::ivec3(0, 0, 0));
+					glm::ivec3 localMax = glm::min(high - chunk->origin, glm::ivec3(CHUNK_MASK, CHUNK_MASK, CHUNK_MASK));
+					function(*chunk, localMin, localMax);
+				}
+			}
 		}
-		else {
-			uint8_t* dataBytes = reinterpret_cast<uint8_t*>(data);
-
-			for (int y = 0; y < texHeight; y++) {
-				memcpy(&dataBytes[y * stagingImageLayout.rowPitch], &pixels[y * texWidth * 4], texWidth * 4);
+	}
+	void removeEmptyChunks(glm::ivec3 min, glm::ivec3 max) {
+		glm::ivec3 low = glm::min(min, max);
+		glm::ivec3 high = glm::max(min, max);
+		for (int chunkX = low.x >> CHUNK_SHIFT; chunkX <= high.x >> CHUNK_SHIFT; chunkX++) {
+			for (int chunkY = low.y >> CHUNK_SHIFT; chunkY <= high.y >> CHUNK_SHIFT; chunkY++) {
+				for (int chunkZ = low.z >> CHUNK_SHIFT; chunkZ <= high.z >> CHUNK_SHIFT; chunkZ++) {
+					auto it = chunks.find(packBlockPosition(chunkX, chunkY, chunkZ));
+					if (it != chunks.end() && it->second->blockCount == 0) {
+						eraseChunk(it);
+					}
+				}
 			}
 		}
-
-		vkUnmapMemory(device, stagingImageMemory);
-
-		stbi_image_free(pixels);
-
-		createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
-
-		transitionImageLayout(stagingImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyImage(stagingImage, textureImage, texWidth, texHeight);
-
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
-
-	//creating the image object
-	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VDeleter<VkImage>& image, VDeleter<VkDeviceMemory>& imageMemory) {
-		VkImageCreateInfo imageInfo = {};
-		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.extent.width = width;
-		imageInfo.extent.height = height;
-		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
-		imageInfo.arrayLayers = 1;
-		imageInfo.format = format;
-		imageInfo.tiling = tiling;
-		imageInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
-		imageInfo.usage = usage;
-		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		if (vkCreateImage(device, &imageInfo, nullptr, image.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create image!");
+	//finds the chunk and cell next to a cell, returns null if that cell's chunk doesn't exist
+	//another chunk is only made writable when the neighbour cell holds a block, the only case updateNeighbours changes it
+	Chunk* getNeighbourCell(Chunk& chunk, int cell, int direction, int* neighbourCell) {
+		glm::ivec3 local = glm::ivec3(cell & CHUNK_MASK, cell >> (CHUNK_SHIFT * 2), (cell >> CHUNK_SHIFT) & CHUNK_MASK);
+		static const glm::ivec3 offsets[6] = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
+		local += offsets[direction];
+		*neighbourCell = chunkCell(local.x & CHUNK_MASK, local.y & CHUNK_MASK, local.z & CHUNK_MASK);
+		//most neighbours are in the same chunk, only the cells on the chunk's faces need a lookup
+		if (local.x >= 0 && local.x < CHUNK_SIZE && local.y >= 0 && local.y < CHUNK_SIZE && local.z >= 0 && local.z < CHUNK_SIZE) {
+			return &chunk;
 		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, imageMemory.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
+		glm::ivec3 position = chunk.origin + local;
+		auto it = chunks.find(packBlockPosition(position.x >> CHUNK_SHIFT, position.y >> CHUNK_SHIFT, position.z >> CHUNK_SHIFT));
+		if (it == chunks.end()) {
+			return nullptr;
+		}
+		return it->second->occupied[*neighbourCell] ? &getWritableChunk(it->second) : it->second.get();
+	}
+	//keeps the neighbour masks right when a cell is filled or emptied, only the six cells around it change
+	void updateNeighbours(Chunk& chunk, int cell, bool occupied) {
+		uint8_t mask = 0;
+		for (int direction = 0; direction < 6; direction++) {
+			int neighbourCell;
+			Chunk* neighbourChunk = getNeighbourCell(chunk, cell, direction, &neighbourCell);
+			if (neighbourChunk == nullptr || !neighbourChunk->occupied[neighbourCell]) {
+				continue;
+			}
+			mask |= 1 << direction;
+			//directions come in +/- pairs, so the opposite direction only differs in the lowest bit
+			uint8_t opposite = 1 << (direction ^ 1);
+			if (occupied) {
+				neighbourChunk->neighbours[neighbourCell] |= opposite;
+			}
+			else {
+				neighbourChunk->neighbours[neighbourCell] &= ~opposite;
+			}
+		}
+		chunk.neighbours[cell] = mask;
+	}
+	//puts a block into an empty cell and gives it a slot
+	BlockHandle insertBlock(Chunk& chunk, int cell, uint8_t packed) {
+		//reuse the most recently freed slot, otherwise grow the slot array
+		uint32_t index = freeSlot;
+		if (index != UINT32_MAX) {
+			freeSlot = slots[index].dense;
+		}
+		else {
+			index = (uint32_t)slots.size();
+			slots.push_back(BlockSlot());
+		}
+		slots[index].dense = (uint32_t)denseBlocks.size();
+		chunk.cells[cell] = packed;
+		denseBlocks.push_back(chunk.getBlock(cell));
+		denseToSlot.push_back(index);
+
+		chunk.insertSlot(cell, index);
+		chunk.occupied[cell] = true;
+		chunk.blockCount++;
+		blockCount++;
+		updateNeighbours(chunk, cell, true);
+
+		BlockHandle handle;
+		handle.index = index;
+		handle.generation = slots[index].generation;
+		return handle;
+	}
+	//changes the type and direction of an occupied cell, its handle stays valid
+	void setBlock(Chunk& chunk, int cell, uint8_t packed) {
+		chunk.cells[cell] = packed;
+		denseBlocks[slots[chunk.getSlot(cell)].dense] = chunk.getBlock(cell);
+	}
+	//empties an occupied cell and frees its slot, the chunk is left in the map even if it is now empty
+	void eraseBlock(Chunk& chunk, int cell) {
+		uint32_t index = chunk.getSlot(cell);
+		BlockSlot& slot = slots[index];
+		chunk.eraseSlot(cell);
+		chunk.occupied[cell] = false;
+		chunk.blockCount--;
+		blockCount--;
+		updateNeighbours(chunk, cell, false);
+
+		//the last block in the dense array is moved into the hole
+		uint32_t last = (uint32_t)denseBlocks.size() - 1;
+		if (slot.dense != last) {
+			denseBlocks[slot.dense] = denseBlocks[last];
+			denseToSlot[slot.dense] = denseToSlot[last];
+			slots[denseToSlot[last]].dense = slot.dense;
 		}
+		denseBlocks.pop_back();
+		denseToSlot.pop_back();
 
-		vkBindImageMemory(device, image, imageMemory, 0);
+		//bumping the generation invalidates every handle to the removed block
+		slot.generation++;
+		slot.dense = freeSlot;
+		freeSlot = index;
 	}
 
-	void copyImage(VkImage srcImage, VkImage dstImage, uint32_t width, uint32_t height) {
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	std::vector<Block> denseBlocks;
+	std::vector<uint32_t> denseToSlot;
+	std::vector<BlockSlot> slots;
+	uint32_t freeSlot = UINT32_MAX;
 
-		VkImageSubresourceLayers subResource = {};
-		subResource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subResource.baseArrayLayer = 0;
-		subResource.mipLevel = 0;
-		subResource.layerCount = 1;
-
-		VkImageCopy region = {};
-		region.srcSubresource = subResource;
-		region.dstSubresource = subResource;
-		region.srcOffset = { 0, 0, 0 };
-		region.dstOffset = { 0, 0, 0 };
-		region.extent.width = width;
-		region.extent.height = height;
-		region.extent.depth = 1;
+};
 
-		vkCmdCopyImage(
-			commandBuffer,
-			srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1, &region
-		);
+//sparse voxel octree over the same 21 bit coordinate range as the chunk map, for huge workspaces that are mostly empty
+//the leaves are 4x4x4 bricks with a 64 bit occupancy mask, so memory follows the occupied space and empty space is skipped a whole node at a time
+const int OCTREE_BITS = 21;
+const int OCTREE_BIAS = 1 << (OCTREE_BITS - 1);
+const int BRICK_SHIFT = 2;
+const int BRICK_MASK = (1 << BRICK_SHIFT) - 1;
 
-		endSingleTimeCommands(commandBuffer);
+class BlockOctree {
+public:
+	//index 0 of both pools is never a child (the root and an unused brick), so 0 can mean "no child"
+	BlockOctree() {
+		nodes.push_back(OctreeNode());
+		bricks.push_back(OctreeBrick());
 	}
 
-	bool hasStencilComponent(VkFormat format) {
-		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+	bool addBlock(int x, int y, int z, blockType type) {
+		return addBlock(x, y, z, type, positiveY);
 	}
-
-	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier = {};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-
-		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-
-			if (hasStencilComponent(format)) {
-				barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+	//returns false if the position is taken or outside the tree
+	bool addBlock(int x, int y, int z, blockType type, blockDirection direction) {
+		glm::ivec3 position;
+		if (!toTree(x, y, z, &position)) {
+			return false;
+		}
+		uint32_t node = 0;
+		for (int bit = OCTREE_BITS - 1; bit > BRICK_SHIFT; bit--) {
+			uint32_t& child = nodes[node].children[getChild(position, bit)];
+			if (child == 0) {
+				uint32_t created = allocateNode();
+				//the pool may have grown, so the reference can't be used after allocating
+				nodes[node].children[getChild(position, bit)] = created;
+				node = created;
+			}
+			else {
+				node = child;
 			}
 		}
-		else {
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		uint32_t brick = nodes[node].children[getChild(position, BRICK_SHIFT)];
+		if (brick == 0) {
+			brick = allocateBrick();
+			nodes[node].children[getChild(position, BRICK_SHIFT)] = brick;
 		}
+		int cell = getBrickCell(position);
+		if (bricks[brick].occupied & (1ull << cell)) {
+			return false;
+		}
+		bricks[brick].occupied |= 1ull << cell;
+		bricks[brick].cells[cell] = packBlock(type, direction);
+		blockCount++;
+		return true;
+	}
+	int getVectorSize() {
+		return blockCount;
+	}
+	//empty bricks and nodes are freed on the way back up so memory only covers occupied space
+	bool removeBlock(int x, int y, int z) {
+		glm::ivec3 position;
+		if (!toTree(x, y, z, &position)) {
+			return false;
+		}
+		uint32_t path[OCTREE_BITS];
+		int depth = 0;
+		uint32_t node = 0;
+		for (int bit = OCTREE_BITS - 1; bit > BRICK_SHIFT; bit--) {
+			path[depth++] = node;
+			node = nodes[node].children[getChild(position, bit)];
+			if (node == 0) {
+				return false;
+			}
+		}
+		uint32_t brick = nodes[node].children[getChild(position, BRICK_SHIFT)];
+		int cell = getBrickCell(position);
+		if (brick == 0 || !(bricks[brick].occupied & (1ull << cell))) {
+			return false;
+		}
+		bricks[brick].occupied &= ~(1ull << cell);
+		blockCount--;
+		if (bricks[brick].occupied != 0) {
+			return true;
+		}
+		freeBricks.push_back(brick);
+		nodes[node].children[getChild(position, BRICK_SHIFT)] = 0;
+		for (int bit = BRICK_SHIFT + 1; bit < OCTREE_BITS && isEmpty(node); bit++) {
+			uint32_t parent = path[--depth];
+			nodes[parent].children[getChild(position, bit)] = 0;
+			freeNodes.push_back(node);
+			node = parent;
+		}
+		return true;
+	}
+	bool doesBlockExist(int x, int y, int z) {
+		glm::ivec3 position;
+		uint32_t brick = findBrick(x, y, z, &position);
+		return brick != 0 && (bricks[brick].occupied & (1ull << getBrickCell(position)));
+	}
+	bool getBlock(int x, int y, int z, Block* block) {
+		glm::ivec3 position;
+		uint32_t brick = findBrick(x, y, z, &position);
+		int cell = getBrickCell(position);
+		if (brick == 0 || !(bricks[brick].occupied & (1ull << cell))) {
+			return false;
+		}
+		uint8_t packed = bricks[brick].cells[cell];
+		*block = Block(x, y, z, (blockType)(packed >> 3), (blockDirection)(packed & 7));
+		return true;
+	}
+	//appends every block inside the inclusive box to found, subtrees outside the box or with no blocks are never visited
+	void getBlocksInRegion(glm::ivec3 min, glm::ivec3 max, std::vector<Block>* found) {
+		glm::ivec3 low = glm::clamp(glm::min(min, max) + OCTREE_BIAS, 0, (1 << OCTREE_BITS) - 1);
+		glm::ivec3 high = glm::clamp(glm::max(min, max) + OCTREE_BIAS, 0, (1 << OCTREE_BITS) - 1);
+		collectBlocks(0, OCTREE_BITS - 1, glm::ivec3(0, 0, 0), low, high, found);
+	}
+	//walks the cells the ray passes through like BlockQueries::ray, except that every empty node it passes is crossed in one step
+	//returns true and the first block hit if there is one within maxDistance
+	bool raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, glm::ivec3* hit) {
+		direction = glm::normalize(direction);
+		glm::ivec3 cell = glm::ivec3(glm::floor(origin));
+		glm::ivec3 step;
+		for (int axis = 0; axis < 3; axis++) {
+			step[axis] = direction[axis] > 0 ? 1 : direction[axis] < 0 ? -1 : 0;
+		}
+		while (true) {
+			glm::ivec3 position;
+			if (!toTree(cell.x, cell.y, cell.z, &position)) {
+				return false;
+			}
+			int size = getEmptySize(position);
+			if (size == 0) {
+				*hit = cell;
+				return true;
+			}
+			//leave the empty box through whichever face the ray reaches first
+			//worked out in double, far from the origin a float can't tell neighbouring cells apart
+			glm::ivec3 boxMin = (position & ~(size - 1)) - OCTREE_BIAS;
+			glm::ivec3 boxMax = boxMin + (size - 1);
+			int exitAxis = 0;
+			double exit = std::numeric_limits<double>::infinity();
+			for (int axis = 0; axis < 3; axis++) {
+				if (step[axis] != 0) {
+					int face = step[axis] > 0 ? boxMax[axis] + 1 : boxMin[axis];
+					double axisExit = ((double)face - origin[axis]) / direction[axis];
+					if (axisExit < exit) {
+						exit = axisExit;
+						exitAxis = axis;
+					}
+				}
+			}
+			if (exit > maxDistance) {
+				return false;
+			}
+			//the next cell is the one just past the exit face, on the other axes it's where the ray is at that point within the box
+			for (int axis = 0; axis < 3; axis++) {
+				if (axis == exitAxis) {
+					cell[axis] = step[axis] > 0 ? boxMax[axis] + 1 : boxMin[axis] - 1;
+				}
+				else if (step[axis] != 0) {
+					int along = (int)std::floor(origin[axis] + direction[axis] * exit);
+					//rounding must never move the ray back, then every step is a step forward and the walk always ends
+					along = step[axis] > 0 ? std::max(along, cell[axis]) : std::min(along, cell[axis]);
+					cell[axis] = glm::clamp(along, boxMin[axis], boxMax[axis]);
+				}
+			}
+		}
+	}
+	//approximate bytes used by the node and brick pools
+	size_t getMemoryUsage() const {
+		return nodes.capacity() * sizeof(OctreeNode) + bricks.capacity() * sizeof(OctreeBrick) + (freeNodes.capacity() + freeBricks.capacity()) * sizeof(uint32_t);
+	}
+private:
+	struct OctreeNode {
+		//nodes in the level above the bricks hold brick indices, every other level holds node indices
+		uint32_t children[8] = {};
+	};
+	struct OctreeBrick {
+		uint64_t occupied = 0;
+		//packed like chunk cells, x changes fastest then z then y
+		uint8_t cells[64];
+	};
+	std::vector<OctreeNode> nodes;
+	std::vector<OctreeBrick> bricks;
+	std::vector<uint32_t> freeNodes;
+	std::vector<uint32_t> freeBricks;
+	int blockCount = 0;
+
+	//moves the position into the tree's unsigned range, returns false if it doesn't fit
+	bool toTree(int x, int y, int z, glm::ivec3* position) {
+		*position = glm::ivec3(x, y, z) + OCTREE_BIAS;
+		return (unsigned)position->x < (1u << OCTREE_BITS) && (unsigned)position->y < (1u << OCTREE_BITS) && (unsigned)position->z < (1u << OCTREE_BITS);
+	}
+	int getChild(glm::ivec3 position, int bit) {
+		return ((position.x >> bit) & 1) | (((position.y >> bit) & 1) << 1) | (((position.z >> bit) & 1) << 2);
+	}
+	int getBrickCell(glm::ivec3 position) {
+		return (position.x & BRICK_MASK) | ((position.z & BRICK_MASK) << BRICK_SHIFT) | ((position.y & BRICK_MASK) << (BRICK_SHIFT * 2));
+	}
+	bool isEmpty(uint32_t node) {
+		for (int i = 0; i < 8; i++) {
+			if (nodes[node].children[i] != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+	uint32_t allocateNode() {
+		if (!freeNodes.empty()) {
+			uint32_t node = freeNodes.back();
+			freeNodes.pop_back();
+			nodes[node] = OctreeNode();
+			return node;
+		}
+		nodes.push_back(OctreeNode());
+		return (uint32_t)nodes.size() - 1;
+	}
+	uint32_t allocateBrick() {
+		if (!freeBricks.empty()) {
+			uint32_t brick = freeBricks.back();
+			freeBricks.pop_back();
+			bricks[brick].occupied = 0;
+			return brick;
+		}
+		bricks.push_back(OctreeBrick());
+		return (uint32_t)bricks.size() - 1;
+	}
+	//returns the brick holding the position or 0 if there isn't one
+	uint32_t findBrick(int x, int y, int z, glm::ivec3* position) {
+		if (!toTree(x, y, z, position)) {
+			return 0;
+		}
+		uint32_t node = 0;
+		for (int bit = OCTREE_BITS - 1; bit > BRICK_SHIFT; bit--) {
+			node = nodes[node].children[getChild(*position, bit)];
+			if (node == 0) {
+				return 0;
+			}
+		}
+		return nodes[node].children[getChild(*position, BRICK_SHIFT)];
+	}
+	//size of the largest empty node or brick cell holding the position, 0 if the position holds a block
+	int getEmptySize(glm::ivec3 position) {
+		uint32_t node = 0;
+		for (int bit = OCTREE_BITS - 1; bit > BRICK_SHIFT; bit--) {
+			node = nodes[node].children[getChild(position, bit)];
+			if (node == 0) {
+				return 1 << bit;
+			}
+		}
+		uint32_t brick = nodes[node].children[getChild(position, BRICK_SHIFT)];
+		if (brick == 0) {
+			return 1 << BRICK_SHIFT;
+		}
+		return (bricks[brick].occupied & (1ull << getBrickCell(position))) ? 0 : 1;
+	}
+	//the node at nodeMin covers 2^(bit + 1) cells per axis, its children cover 2^bit
+	void collectBlocks(uint32_t node, int bit, glm::ivec3 nodeMin, glm::ivec3 low, glm::ivec3 high, std::vector<Block>* found) {
+		int childSize = 1 << bit;
+		for (int child = 0; child < 8; child++) {
+			uint32_t index = nodes[node].children[child];
+			if (index == 0) {
+				continue;
+			}
+			glm::ivec3 childMin = nodeMin + glm::ivec3(child & 1, (child >> 1) & 1, (child >> 2) & 1) * childSize;
+			glm::ivec3 childMax = childMin + glm::ivec3(childSize - 1);
+			if (glm::any(glm::lessThan(childMax, low)) || glm::any(glm::greaterThan(childMin, high))) {
+				continue;
+			}
+			if (bit > BRICK_SHIFT) {
+				collectBlocks(index, bit - 1, childMin, low, high, found);
+				continue;
+			}
+			const OctreeBrick& brick = bricks[index];
+			for (int cell = 0; cell < 64; cell++) {
+				if (!(brick.occupied & (1ull << cell))) {
+					continue;
+				}
+				glm::ivec3 position = childMin + glm::ivec3(cell & BRICK_MASK, cell >> (BRICK_SHIFT * 2), (cell >> BRICK_SHIFT) & BRICK_MASK);
+				if (glm::all(glm::greaterThanEqual(position, low)) && glm::all(glm::lessThanEqual(position, high))) {
+					uint8_t packed = brick.cells[cell];
+					glm::ivec3 world = position - OCTREE_BIAS;
+					found->push_back(Block(world.x, world.y, world.z, (blockType)(packed >> 3), (blockDirection)(packed & 7)));
+				}
+			}
+		}
+	}
+};
 
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-
-		if (oldLayout == VK_IMAGE_LAYOUT_PREINITIALIZED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+//spatial queries over the chunk map, results go into buffers the caller owns so no query allocates
+//the box, sphere and nearest queries return how many blocks they found, only the first maxResults of them are written
+class BlockQueries {
+public:
+	BlockQueries(Blocks* _blocks) { blocks = _blocks; }
+
+	//every block inside the inclusive box
+	int box(glm::ivec3 min, glm::ivec3 max, Block* results, int maxResults) {
+		int count = 0;
+		forEachBlockInBox(min, max, [&](const Block& block) {
+			if (count < maxResults) {
+				results[count] = block;
+			}
+			count++;
+		});
+		return count;
+	}
+	//every block whose centre is within radius of center
+	int sphere(glm::vec3 center, float radius, Block* results, int maxResults) {
+		int count = 0;
+		glm::ivec3 min = glm::ivec3(glm::floor(center - radius));
+		glm::ivec3 max = glm::ivec3(glm::floor(center + radius));
+		forEachBlockInBox(min, max, [&](const Block& block) {
+			if (getDistanceSquared(center, block) > radius * radius) {
+				return;
+			}
+			if (count < maxResults) {
+				results[count] = block;
+			}
+			count++;
+		});
+		return count;
+	}
+	//walks the cells the ray passes through in order (Amanatides and Woo), a cell in a missing chunk is stepped over without a lookup
+	//returns true with the first block hit and the normal of the face the ray entered it through
+	bool ray(glm::vec3 origin, glm::vec3 direction, float maxDistance, glm::ivec3* hit, glm::ivec3* normal) {
+		direction = glm::normalize(direction);
+		glm::ivec3 cell = glm::ivec3(glm::floor(origin));
+		glm::ivec3 step;
+		glm::vec3 delta;
+		glm::vec3 next;
+		for (int axis = 0; axis < 3; axis++) {
+			step[axis] = direction[axis] > 0 ? 1 : direction[axis] < 0 ? -1 : 0;
+			delta[axis] = direction[axis] != 0 ? std::abs(1 / direction[axis]) : std::numeric_limits<float>::infinity();
+			if (direction[axis] > 0) {
+				next[axis] = (cell[axis] + 1 - origin[axis]) / direction[axis];
+			}
+			else if (direction[axis] < 0) {
+				next[axis] = (origin[axis] - cell[axis]) / -direction[axis];
+			}
+			else {
+				next[axis] = std::numeric_limits<float>::infinity();
+			}
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_PREINITIALIZED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		*normal = glm::ivec3(0, 0, 0);
+		float t = 0;
+		const Chunk* chunk = nullptr;
+		glm::ivec3 chunkPosition = glm::ivec3(INT_MAX, INT_MAX, INT_MAX);
+		while (t <= maxDistance) {
+			glm::ivec3 cellChunk = glm::ivec3(cell.x >> CHUNK_SHIFT, cell.y >> CHUNK_SHIFT, cell.z >> CHUNK_SHIFT);
+			if (cellChunk != chunkPosition) {
+				chunkPosition = cellChunk;
+				auto it = blocks->chunks.find(packBlockPosition(cellChunk.x, cellChunk.y, cellChunk.z));
+				chunk = it == blocks->chunks.end() ? nullptr : it->second.get();
+			}
+			if (chunk != nullptr && chunk->occupied[chunkCell(cell.x & CHUNK_MASK, cell.y & CHUNK_MASK, cell.z & CHUNK_MASK)]) {
+				*hit = cell;
+				return true;
+			}
+			int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+			cell[axis] += step[axis];
+			t = next[axis];
+			next[axis] += delta[axis];
+			*normal = glm::ivec3(0, 0, 0);
+			(*normal)[axis] = -step[axis];
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		return false;
+	}
+	//the k blocks whose centres are nearest to point within maxDistance, nearest first, results must hold k blocks
+	//chunks are searched in growing shells around the point's chunk until no block left outside can be nearer
+	int nearest(glm::vec3 point, int k, float maxDistance, Block* results) {
+		glm::ivec3 low;
+		glm::ivec3 high;
+		if (k <= 0 || !blocks->getChunkBounds(&low, &high)) {
+			return 0;
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		int count = 0;
+		glm::ivec3 center = glm::ivec3(glm::floor(point)) >> CHUNK_SHIFT;
+		//shells past the outermost chunk are empty, so the search never goes further than that whatever maxDistance is (infinity means no limit)
+		glm::ivec3 extent = glm::max(glm::abs(center - low), glm::abs(high - center));
+		int maxShell = std::max(extent.x, std::max(extent.y, extent.z));
+		//compared as a float first, converting a distance past the int range is undefined
+		if (maxDistance / CHUNK_SIZE + 1 < (float)maxShell) {
+			maxShell = (int)(maxDistance / CHUNK_SIZE) + 1;
 		}
-		else {
-			throw std::invalid_argument("unsupported layout transition!");
+		auto getChunkDistance = [&](const Chunk& chunk) {
+			glm::vec3 closest = glm::clamp(point, glm::vec3(chunk.origin), glm::vec3(chunk.origin + CHUNK_SIZE));
+			return glm::dot(closest - point, closest - point);
+		};
+		//false if the chunk can't hold anything nearer than what was found already
+		auto isWorthSearching = [&](float chunkDistance) {
+			return chunkDistance <= maxDistance * maxDistance && (count < k || chunkDistance < getDistanceSquared(point, results[k - 1]));
+		};
+		auto searchChunk = [&](const Chunk& chunk) {
+			for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+				if (!chunk.occupied[cell]) {
+					continue;
+				}
+				Block block = chunk.getBlock(cell);
+				float distance = getDistanceSquared(point, block);
+				if (distance > maxDistance * maxDistance || (count == k && distance >= getDistanceSquared(point, results[k - 1]))) {
+					continue;
+				}
+				//insertion into the sorted results, k is small
+				int i = count < k ? count++ : k - 1;
+				while (i > 0 && getDistanceSquared(point, results[i - 1]) > distance) {
+					results[i] = results[i - 1];
+					i--;
+				}
+				results[i] = block;
+			}
+		};
+		//searches the chunks in a box of offsets from the center chunk, clipped to the chunks that exist
+		auto searchBox = [&](glm::ivec3 from, glm::ivec3 to) {
+			from = glm::max(from, low - center);
+			to = glm::min(to, high - center);
+			for (int x = from.x; x <= to.x; x++) {
+				for (int y = from.y; y <= to.y; y++) {
+					for (int z = from.z; z <= to.z; z++) {
+						auto it = blocks->chunks.find(packBlockPosition(center.x + x, center.y + y, center.z + z));
+						if (it != blocks->chunks.end() && isWorthSearching(getChunkDistance(*it->second))) {
+							searchChunk(*it->second);
+						}
+					}
+				}
+			}
+		};
+		int shell = 0;
+		for (; shell <= maxShell; shell++) {
+			//once the shells cover more cells than the world has chunks it's cheaper to go through the chunks themselves
+			if ((size_t)(2 * shell + 1) * (2 * shell + 1) * (2 * shell + 1) > blocks->chunks.size()) {
+				break;
+			}
+			//only the six faces of the shell, the inside was searched already
+			searchBox(glm::ivec3(-shell, -shell, -shell), glm::ivec3(-shell, shell, shell));
+			if (shell > 0) {
+				searchBox(glm::ivec3(shell, -shell, -shell), glm::ivec3(shell, shell, shell));
+				searchBox(glm::ivec3(1 - shell, -shell, -shell), glm::ivec3(shell - 1, -shell, shell));
+				searchBox(glm::ivec3(1 - shell, shell, -shell), glm::ivec3(shell - 1, shell, shell));
+				searchBox(glm::ivec3(1 - shell, 1 - shell, -shell), glm::ivec3(shell - 1, shell - 1, -shell));
+				searchBox(glm::ivec3(1 - shell, 1 - shell, shell), glm::ivec3(shell - 1, shell - 1, shell));
+			}
+			//anything in the next shell is at least shell chunks away from the point's chunk
+			float reach = (float)(shell * CHUNK_SIZE);
+			if (count == k && getDistanceSquared(point, results[k - 1]) <= reach * reach) {
+				return count;
+			}
+		}
+		if (shell > maxShell) {
+			return count;
+		}
+		//the chunks outside the shells searched so far, nearest first, stopping at the first one too far to matter
+		std::vector<std::pair<float, const Chunk*>> candidates;
+		for (auto& chunkEntry : blocks->chunks) {
+			glm::ivec3 offset = glm::abs((chunkEntry.second->origin >> CHUNK_SHIFT) - center);
+			float chunkDistance = getChunkDistance(*chunkEntry.second);
+			if (std::max(offset.x, std::max(offset.y, offset.z)) >= shell && isWorthSearching(chunkDistance)) {
+				candidates.push_back(std::make_pair(chunkDistance, chunkEntry.second.get()));
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, const Chunk*>& a, const std::pair<float, const Chunk*>& b) { return a.first < b.first; });
+		for (auto& candidate : candidates) {
+			if (!isWorthSearching(candidate.first)) {
+				break;
+			}
+			searchChunk(*candidate.second);
 		}
+		return count;
+	}
 
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
+	//batched versions, query i writes its results from results + i * maxResults (or i * k) and its count to counts[i]
+	void boxes(const glm::ivec3* mins, const glm::ivec3* maxes, int queryCount, Block* results, int maxResults, int* counts) {
+		for (int i = 0; i < queryCount; i++) {
+			counts[i] = box(mins[i], maxes[i], results + i * maxResults, maxResults);
+		}
+	}
+	void spheres(const glm::vec3* centers, const float* radii, int queryCount, Block* results, int maxResults, int* counts) {
+		for (int i = 0; i < queryCount; i++) {
+			counts[i] = sphere(centers[i], radii[i], results + i * maxResults, maxResults);
+		}
+	}
+	void rays(const glm::vec3* origins, const glm::vec3* directions, int queryCount, float maxDistance, glm::ivec3* hits, glm::ivec3* normals, bool* found) {
+		for (int i = 0; i < queryCount; i++) {
+			found[i] = ray(origins[i], directions[i], maxDistance, hits + i, normals + i);
+		}
+	}
+	void nearests(const glm::vec3* points, int queryCount, int k, float maxDistance, Block* results, int* counts) {
+		for (int i = 0; i < queryCount; i++) {
+			counts[i] = nearest(points[i], k, maxDistance, results + i * k);
+		}
+	}
+private:
+	Blocks* blocks;
+
+	float getDistanceSquared(glm::vec3 point, const Block& block) {
+		glm::vec3 offset = glm::vec3(block.position) + glm::vec3(0.5f, 0.5f, 0.5f) - point;
+		return glm::dot(offset, offset);
+	}
+	//calls function(block) for every block in the inclusive box, one chunk lookup per chunk the box touches
+	template<typename Function>
+	void forEachBlockInBox(glm::ivec3 min, glm::ivec3 max, Function function) {
+		for (int chunkX = min.x >> CHUNK_SHIFT; chunkX <= max.x >> CHUNK_SHIFT; chunkX++) {
+			for (int chunkY = min.y >> CHUNK_SHIFT; chunkY <= max.y >> CHUNK_SHIFT; chunkY++) {
+				for (int chunkZ = min.z >> CHUNK_SHIFT; chunkZ <= max.z >> CHUNK_SHIFT; chunkZ++) {
+					auto it = blocks->chunks.find(packBlockPosition(chunkX, chunkY, chunkZ));
+					if (it == blocks->chunks.end()) {
+						continue;
+					}
+					const Chunk& chunk = *it->second;
+					glm::ivec3 localMin = glm::max(min - chunk.origin, glm::ivec3(0, 0, 0));
+					glm::ivec3 localMax = glm::min(max - chunk.origin, glm::ivec3(CHUNK_MASK, CHUNK_MASK, CHUNK_MASK));
+					for (int y = localMin.y; y <= localMax.y; y++) {
+						for (int z = localMin.z; z <= localMax.z; z++) {
+							for (int x = localMin.x; x <= localMax.x; x++) {
+								int cell = chunkCell(x, y, z);
+								if (chunk.occupied[cell]) {
+									function(chunk.getBlock(cell));
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+};
 
-		endSingleTimeCommands(commandBuffer);
+//positions split into one array per axis, so the batch kernels below work on 4 (sse) or 8 (avx) vertices per instruction
+struct PositionStream {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	size_t size() const { return x.size(); }
+	void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); }
+	void load(const std::vector<Vertex>& vertices) {
+		resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			x[i] = vertices[i].pos.x;
+			y[i] = vertices[i].pos.y;
+			z[i] = vertices[i].pos.z;
+		}
+	}
+	//writes the positions back over vertices that already hold the rest of each vertex
+	void store(std::vector<Vertex>* vertices) const {
+		for (size_t i = 0; i < size(); i++) {
+			(*vertices)[i].pos = glm::vec3(x[i], y[i], z[i]);
+		}
 	}
+};
 
-	VkCommandBuffer beginSingleTimeCommands() {
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
+//the plain loops, used for whatever is left over after the vector loop and on their own where there is no sse
+static void translatePositionRange(PositionStream* stream, glm::vec3 offset, size_t begin, size_t end) {
+	for (size_t i = begin; i < end; i++) {
+		stream->x[i] += offset.x;
+		stream->y[i] += offset.y;
+		stream->z[i] += offset.z;
+	}
+}
+static void transformPositionRange(const PositionStream& in, PositionStream* out, const glm::mat4& m, size_t begin, size_t end) {
+	for (size_t i = begin; i < end; i++) {
+		float x = in.x[i];
+		float y = in.y[i];
+		float z = in.z[i];
+		out->x[i] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+		out->y[i] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+		out->z[i] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+	}
+}
+void translatePositionsScalar(PositionStream* stream, glm::vec3 offset) {
+	translatePositionRange(stream, offset, 0, stream->size());
+}
+void transformPositionsScalar(const PositionStream& in, PositionStream* out, const glm::mat4& m) {
+	out->resize(in.size());
+	transformPositionRange(in, out, m, 0, in.size());
+}
 
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+void translatePositions(PositionStream* stream, glm::vec3 offset) {
+	size_t count = stream->size();
+	size_t i = 0;
+#if defined(SIMD_AVX)
+	__m256 offsetX = _mm256_set1_ps(offset.x);
+	__m256 offsetY = _mm256_set1_ps(offset.y);
+	__m256 offsetZ = _mm256_set1_ps(offset.z);
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(&stream->x[i], _mm256_add_ps(_mm256_loadu_ps(&stream->x[i]), offsetX));
+		_mm256_storeu_ps(&stream->y[i], _mm256_add_ps(_mm256_loadu_ps(&stream->y[i]), offsetY));
+		_mm256_storeu_ps(&stream->z[i], _mm256_add_ps(_mm256_loadu_ps(&stream->z[i]), offsetZ));
+	}
+#elif defined(SIMD_SSE)
+	__m128 offsetX = _mm_set1_ps(offset.x);
+	__m128 offsetY = _mm_set1_ps(offset.y);
+	__m128 offsetZ = _mm_set1_ps(offset.z);
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(&stream->x[i], _mm_add_ps(_mm_loadu_ps(&stream->x[i]), offsetX));
+		_mm_storeu_ps(&stream->y[i], _mm_add_ps(_mm_loadu_ps(&stream->y[i]), offsetY));
+		_mm_storeu_ps(&stream->z[i], _mm_add_ps(_mm_loadu_ps(&stream->z[i]), offsetZ));
+	}
+#endif
+	translatePositionRange(stream, offset, i, count);
+}
 
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+//any affine transform, out may be the same stream as in since each batch is read before it is written
+void transformPositions(const PositionStream& in, PositionStream* out, const glm::mat4& m) {
+	out->resize(in.size());
+	size_t count = in.size();
+	size_t i = 0;
+#if defined(SIMD_AVX)
+	__m256 column[4][3];
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 3; r++) {
+			column[c][r] = _mm256_set1_ps(m[c][r]);
+		}
+	}
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(&in.x[i]);
+		__m256 y = _mm256_loadu_ps(&in.y[i]);
+		__m256 z = _mm256_loadu_ps(&in.z[i]);
+		float* outputs[3] = { &out->x[i], &out->y[i], &out->z[i] };
+		for (int r = 0; r < 3; r++) {
+			__m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(column[0][r], x), _mm256_mul_ps(column[1][r], y)), _mm256_mul_ps(column[2][r], z)), column[3][r]);
+			_mm256_storeu_ps(outputs[r], result);
+		}
+	}
+#elif defined(SIMD_SSE)
+	__m128 column[4][3];
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 3; r++) {
+			column[c][r] = _mm_set1_ps(m[c][r]);
+		}
+	}
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(&in.x[i]);
+		__m128 y = _mm_loadu_ps(&in.y[i]);
+		__m128 z = _mm_loadu_ps(&in.z[i]);
+		float* outputs[3] = { &out->x[i], &out->y[i], &out->z[i] };
+		for (int r = 0; r < 3; r++) {
+			__m128 result = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(column[0][r], x), _mm_mul_ps(column[1][r], y)), _mm_mul_ps(column[2][r], z)), column[3][r]);
+			_mm_storeu_ps(outputs[r], result);
+		}
+	}
+#endif
+	transformPositionRange(in, out, m, i, count);
+}
 
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+//turns every position by angle about an axis through centre
+void rotatePositions(const PositionStream& in, PositionStream* out, float angle, glm::vec3 axis, glm::vec3 centre) {
+	glm::mat4 turn = glm::translate(glm::mat4(1.0f), centre) * glm::rotate(glm::mat4(1.0f), angle, axis) * glm::translate(glm::mat4(1.0f), -centre);
+	transformPositions(in, out, turn);
+}
 
-		return commandBuffer;
+void addVectorsWithOffset(std::vector<Vertex>* originalVertices, std::vector<uint32_t>* originalIndices, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, glm::vec3 offset) {
+	size_t temp = originalVertices->size();
+	//the source vertices are shared by every mesher thread, so they are copied in one go and the offset goes on the copies
+	//a plain loop, simd adds over interleaved vertices leave most of each register idle and did not reliably beat it
+	originalVertices->insert(originalVertices->end(), vertices->begin(), vertices->end());
+	for (size_t i = temp; i < originalVertices->size(); i++) {
+		(*originalVertices)[i].pos += offset;
+	}
+	for (size_t i = 0; i < indices->size(); i++) {
+		originalIndices->push_back((*indices)[i] + (uint32_t)temp);
 	}
+}
 
-	void endSingleTimeCommands(VkCommandBuffer commandBuffer) {
-		vkEndCommandBuffer(commandBuffer);
+//a rectangle of equal cells found by greedyMerge
+struct GreedyRect { int x; int y; int width; int height; uint8_t value; };
+
+//covers the nonzero cells of a width by height grid with as few rectangles as it can find, growing each one along x and then y
+//cells holding different values never share a rectangle, the grid is cleared as it goes
+void greedyMerge(uint8_t* grid, int width, int height, std::vector<GreedyRect>* rects) {
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width;) {
+			uint8_t value = grid[y * width + x];
+			if (value == 0) {
+				x++;
+				continue;
+			}
+			int rectWidth = 1;
+			while (x + rectWidth < width && grid[y * width + x + rectWidth] == value) {
+				rectWidth++;
+			}
+			int rectHeight = 1;
+			while (y + rectHeight < height) {
+				bool rowMatches = true;
+				for (int i = 0; i < rectWidth && rowMatches; i++) {
+					rowMatches = grid[(y + rectHeight) * width + x + i] == value;
+				}
+				if (!rowMatches) {
+					break;
+				}
+				rectHeight++;
+			}
+			for (int j = 0; j < rectHeight; j++) {
+				memset(&grid[(y + j) * width + x], 0, rectWidth);
+			}
+			GreedyRect rect = { x, y, rectWidth, rectHeight, value };
+			rects->push_back(rect);
+			x += rectWidth;
+		}
+	}
+}
 
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
+//simplifies a mesh by collapsing edges one at a time, always the collapse that moves the surface least by the quadric error metric
+//a position is only ever moved onto one of its neighbours so no new vertices are made, collapses that would flip or pinch the surface are skipped
+//stops at targetTriangles or once the cheapest collapse would move the surface further than maxError
+//candidate collapses wait in a min heap by cost and each position knows its triangles, so a collapse only looks at the triangles around it
+void decimateMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetTriangles, float maxError, std::vector<Vertex>* outVertices, std::vector<uint32_t>* outIndices) {
+	//corners at one position can still differ in colour, so the topology comes from welding equal positions
+	std::vector<int> positionIds(vertices.size());
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> positionVertices;
+	std::unordered_map<glm::vec3, int> positionLookup;
+	for (size_t i = 0; i < vertices.size(); i++) {
+		auto it = positionLookup.find(vertices[i].pos);
+		if (it == positionLookup.end()) {
+			it = positionLookup.emplace(vertices[i].pos, (int)positions.size()).first;
+			positions.push_back(vertices[i].pos);
+			positionVertices.push_back(i);
+		}
+		positionIds[i] = it->second;
+	}
+	std::vector<uint32_t> triangles = indices;
+	size_t triangleCount = triangles.size() / 3;
+	size_t liveTriangles = triangleCount;
+	std::vector<bool> removed(triangleCount, false);
+	std::vector<std::vector<int>> positionTriangles(positions.size());
+	for (size_t t = 0; t < triangleCount; t++) {
+		int a = positionIds[triangles[t * 3]];
+		int b = positionIds[triangles[t * 3 + 1]];
+		int c = positionIds[triangles[t * 3 + 2]];
+		//triangles with two corners at one position cover nothing
+		if (a == b || b == c || a == c) {
+			removed[t] = true;
+			liveTriangles--;
+			continue;
+		}
+		positionTriangles[a].push_back((int)t);
+		positionTriangles[b].push_back((int)t);
+		positionTriangles[c].push_back((int)t);
+	}
+
+	//each position's quadric sums the squared distances to the planes of the triangles around it
+	std::vector<glm::dmat4> quadrics(positions.size(), glm::dmat4(0.0));
+	for (size_t t = 0; t < triangles.size(); t += 3) {
+		glm::dvec3 a = vertices[triangles[t]].pos;
+		glm::dvec3 normal = glm::cross(glm::dvec3(vertices[triangles[t + 1]].pos) - a, glm::dvec3(vertices[triangles[t + 2]].pos) - a);
+		if (glm::length(normal) == 0) {
+			continue;
+		}
+		normal = glm::normalize(normal);
+		glm::dvec4 plane(normal, -glm::dot(normal, a));
+		glm::dmat4 quadric = glm::outerProduct(plane, plane);
+		for (int c = 0; c < 3; c++) {
+			quadrics[positionIds[triangles[t + c]]] += quadric;
+		}
+	}
+	//positions on an open edge stay put so holes don't grow
+	std::vector<bool> locked(positions.size(), false);
+	std::map<std::pair<int, int>, int> edgeUses;
+	for (size_t t = 0; t < triangles.size(); t += 3) {
+		for (int c = 0; c < 3; c++) {
+			int from = positionIds[triangles[t + c]];
+			int to = positionIds[triangles[t + (c + 1) % 3]];
+			edgeUses[std::make_pair(std::min(from, to), std::max(from, to))]++;
+		}
+	}
+	for (auto& edge : edgeUses) {
+		if (edge.second != 2) {
+			locked[edge.first.first] = true;
+			locked[edge.first.second] = true;
+		}
+	}
 
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue);
+	//the positions sharing a live triangle with one position
+	auto getNeighbours = [&](int position, std::vector<int>* neighbours) {
+		neighbours->clear();
+		for (int t : positionTriangles[position]) {
+			for (int c = 0; c < 3; c++) {
+				int id = positionIds[triangles[t * 3 + c]];
+				if (id != position) {
+					neighbours->push_back(id);
+				}
+			}
+		}
+		std::sort(neighbours->begin(), neighbours->end());
+		neighbours->erase(std::unique(neighbours->begin(), neighbours->end()), neighbours->end());
+	};
+	std::vector<int> fromNeighbours;
+	std::vector<int> toNeighbours;
+	auto collapseAllowed = [&](int from, int to) {
+		for (int t : positionTriangles[from]) {
+			int ids[3] = { positionIds[triangles[t * 3]], positionIds[triangles[t * 3 + 1]], positionIds[triangles[t * 3 + 2]] };
+			if (ids[0] == to || ids[1] == to || ids[2] == to) {
+				continue;
+			}
+			//the triangles that survive must keep facing the same way
+			glm::vec3 corners[3];
+			for (int c = 0; c < 3; c++) {
+				corners[c] = positions[ids[c]];
+			}
+			glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			for (int c = 0; c < 3; c++) {
+				if (ids[c] == from) {
+					corners[c] = positions[to];
+				}
+			}
+			glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			if (glm::length(after) == 0 || glm::dot(glm::normalize(before), glm::normalize(after)) < 0.2f) {
+				return false;
+			}
+		}
+		//an edge shared by two triangles has exactly two positions joined to both ends, more and the collapse would pinch the surface
+		getNeighbours(from, &fromNeighbours);
+		getNeighbours(to, &toNeighbours);
+		int shared = 0;
+		for (int neighbour : fromNeighbours) {
+			shared += neighbour != to && std::binary_search(toNeighbours.begin(), toNeighbours.end(), neighbour);
+		}
+		return shared == 2;
+	};
 
-		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+	//a heap entry is out of date once either end has been part of a collapse since it was pushed
+	struct EdgeCollapse { double cost; int from; int to; uint32_t fromVersion; uint32_t toVersion; };
+	auto costlier = [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.cost > b.cost; };
+	std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>, decltype(costlier)> collapses(costlier);
+	std::vector<uint32_t> versions(positions.size(), 0);
+	auto pushCollapse = [&](int from, int to) {
+		if (locked[from]) {
+			return;
+		}
+		glm::dvec4 target(glm::dvec3(positions[to]), 1.0);
+		EdgeCollapse collapse = { glm::dot(target, (quadrics[from] + quadrics[to]) * target), from, to, versions[from], versions[to] };
+		collapses.push(collapse);
+	};
+	for (auto& edge : edgeUses) {
+		pushCollapse(edge.first.first, edge.first.second);
+		pushCollapse(edge.first.second, edge.first.first);
 	}
 
-	void createDescriptorSet() {
-		VkDescriptorSetLayout layouts[] = { descriptorSetLayout };
-		VkDescriptorSetAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = descriptorPool;
-		allocInfo.descriptorSetCount = 1;
-		allocInfo.pSetLayouts = layouts;
-
-		if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate descriptor set!");
+	std::vector<int> changed;
+	while (liveTriangles > targetTriangles && !collapses.empty()) {
+		EdgeCollapse best = collapses.top();
+		collapses.pop();
+		if (best.fromVersion != versions[best.from] || best.toVersion != versions[best.to]) {
+			continue;
+		}
+		//costs only grow as quadrics are merged, so nothing left in the heap is cheaper
+		if (best.cost > (double)maxError * maxError) {
+			break;
+		}
+		if (!collapseAllowed(best.from, best.to)) {
+			continue;
+		}
+		quadrics[best.to] += quadrics[best.from];
+		for (int t : positionTriangles[best.from]) {
+			bool hasTo = false;
+			for (int c = 0; c < 3; c++) {
+				int id = positionIds[triangles[t * 3 + c]];
+				hasTo |= id == best.to;
+				if (id == best.from) {
+					triangles[t * 3 + c] = positionVertices[best.to];
+				}
+			}
+			//triangles on the collapsed edge are gone, the rest now hang off to
+			if (hasTo) {
+				removed[t] = true;
+				liveTriangles--;
+			}
+			else {
+				positionTriangles[best.to].push_back(t);
+			}
+		}
+		positionTriangles[best.from].clear();
+		versions[best.from]++;
+		versions[best.to]++;
+		//the gone triangles are dropped from every position around them, then the edges at to are costed again
+		getNeighbours(best.to, &changed);
+		changed.push_back(best.to);
+		for (int position : changed) {
+			std::vector<int>& around = positionTriangles[position];
+			around.erase(std::remove_if(around.begin(), around.end(), [&](int t) { return removed[t]; }), around.end());
 		}
+		changed.pop_back();
+		for (int neighbour : changed) {
+			pushCollapse(best.to, neighbour);
+			pushCollapse(neighbour, best.to);
+		}
+	}
 
-		VkDescriptorBufferInfo bufferInfo = {};
-		bufferInfo.buffer = uniformBuffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(UniformBufferObject);
+	//only the vertices still in use are kept
+	std::unordered_map<uint32_t, uint32_t> remap;
+	for (size_t t = 0; t < triangleCount; t++) {
+		if (removed[t]) {
+			continue;
+		}
+		for (int c = 0; c < 3; c++) {
+			uint32_t index = triangles[t * 3 + c];
+			auto it = remap.find(index);
+			if (it == remap.end()) {
+				it = remap.emplace(index, (uint32_t)outVertices->size()).first;
+				outVertices->push_back(vertices[index]);
+			}
+			outIndices->push_back(it->second);
+		}
+	}
+}
 
-		VkDescriptorImageInfo imageInfo = {};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = textureImageView;
-		imageInfo.sampler = textureSampler;
+//vertex cache, overdraw and vertex fetch optimisation, run once on every primitive after loading so each block drawn later gets it for free
+const int VERTEX_CACHE_SIZE = 32;
+
+//how a mesh treats the gpu, acmr is vertex shader runs per triangle (0.5 at best, 3 with no reuse), atvr is runs per vertex (1 is perfect)
+//overfetch is bytes read from the vertex buffer per byte in it, read in 64 byte lines
+struct MeshCacheStats { float acmr; float atvr; float overfetch; };
+
+//simulates a 16 entry fifo post transform cache and a small fifo of fetched lines, the fifo is what most hardware is close to
+MeshCacheStats analyzeMesh(const std::vector<uint32_t>& indices, size_t vertexCount, size_t vertexSize) {
+	const int cacheSize = 16;
+	const int lineSize = 64;
+	const int lineCacheSize = 64;
+	std::vector<uint32_t> cache;
+	std::vector<size_t> lines;
+	size_t misses = 0;
+	size_t fetchedLines = 0;
+	for (size_t i = 0; i < indices.size(); i++) {
+		if (std::find(cache.begin(), cache.end(), indices[i]) != cache.end()) {
+			continue;
+		}
+		misses++;
+		cache.insert(cache.begin(), indices[i]);
+		if (cache.size() > cacheSize) {
+			cache.pop_back();
+		}
+		size_t firstLine = indices[i] * vertexSize / lineSize;
+		size_t lastLine = ((indices[i] + 1) * vertexSize - 1) / lineSize;
+		for (size_t line = firstLine; line <= lastLine; line++) {
+			if (std::find(lines.begin(), lines.end(), line) != lines.end()) {
+				continue;
+			}
+			fetchedLines++;
+			lines.insert(lines.begin(), line);
+			if (lines.size() > lineCacheSize) {
+				lines.pop_back();
+			}
+		}
+	}
+	MeshCacheStats stats = {};
+	if (!indices.empty()) {
+		stats.acmr = misses / (indices.size() / 3.0f);
+		stats.atvr = misses / (float)vertexCount;
+		stats.overfetch = fetchedLines * lineSize / (float)(vertexCount * vertexSize);
+	}
+	return stats;
+}
 
-		std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+//Forsyth's score, vertices just used by the last triangle score a flat 0.75, the rest of the cache falls off with age
+//and vertices with few triangles left get a boost so they are finished off instead of left to come back later
+static float getForsythScore(int cachePosition, uint32_t remainingTriangles) {
+	if (remainingTriangles == 0) {
+		return -1.0f;
+	}
+	float score = 0;
+	if (cachePosition >= 3) {
+		score = powf(1.0f - (cachePosition - 3) / (float)(VERTEX_CACHE_SIZE - 3), 1.5f);
+	}
+	else if (cachePosition >= 0) {
+		score = 0.75f;
+	}
+	return score + 2.0f / sqrtf((float)remainingTriangles);
+}
 
-		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = descriptorSet;
-		descriptorWrites[0].dstBinding = 0;
-		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrites[0].descriptorCount = 1;
-		descriptorWrites[0].pBufferInfo = &bufferInfo;
+//Forsyth's linear speed vertex cache optimisation, greedily emits the best scoring triangle using a vertex in the simulated lru cache
+void optimizeVertexCache(std::vector<uint32_t>* indices, size_t vertexCount) {
+	size_t triangleCount = indices->size() / 3;
+	//every vertex's triangles, the ones not emitted yet are kept at the front of its list
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t i = 0; i < indices->size(); i++) {
+		remaining[(*indices)[i]]++;
+	}
+	std::vector<uint32_t> triangleStart(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		triangleStart[v + 1] = triangleStart[v] + remaining[v];
+	}
+	std::vector<uint32_t> vertexTriangles(indices->size());
+	std::vector<uint32_t> filled(vertexCount, 0);
+	for (size_t i = 0; i < indices->size(); i++) {
+		uint32_t v = (*indices)[i];
+		vertexTriangles[triangleStart[v] + filled[v]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		vertexScore[v] = getForsythScore(-1, remaining[v]);
+	}
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	int best = -1;
+	for (size_t t = 0; t < triangleCount; t++) {
+		triangleScore[t] = vertexScore[(*indices)[t * 3]] + vertexScore[(*indices)[t * 3 + 1]] + vertexScore[(*indices)[t * 3 + 2]];
+		if (best < 0 || triangleScore[t] > triangleScore[best]) {
+			best = (int)t;
+		}
+	}
 
-		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[1].dstSet = descriptorSet;
-		descriptorWrites[1].dstBinding = 1;
-		descriptorWrites[1].dstArrayElement = 0;
-		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrites[1].descriptorCount = 1;
-		descriptorWrites[1].pImageInfo = &imageInfo;
-
-		vkUpdateDescriptorSets(device, descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+	std::vector<uint32_t> ordered;
+	ordered.reserve(indices->size());
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	size_t nextUnemitted = 0;
+	for (size_t count = 0; count < triangleCount; count++) {
+		//nothing in the cache has triangles left, carry on from the first triangle not emitted yet
+		if (best < 0) {
+			while (emitted[nextUnemitted]) {
+				nextUnemitted++;
+			}
+			best = (int)nextUnemitted;
+		}
+		emitted[best] = true;
+		const uint32_t* triangle = &(*indices)[best * 3];
+		newCache.assign(triangle, triangle + 3);
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = triangle[k];
+			ordered.push_back(v);
+			uint32_t* list = &vertexTriangles[triangleStart[v]];
+			for (uint32_t j = 0; j < remaining[v]; j++) {
+				if (list[j] == (uint32_t)best) {
+					std::swap(list[j], list[remaining[v] - 1]);
+					remaining[v]--;
+					break;
+				}
+			}
+		}
+		for (size_t c = 0; c < cache.size(); c++) {
+			if (cache[c] != triangle[0] && cache[c] != triangle[1] && cache[c] != triangle[2]) {
+				newCache.push_back(cache[c]);
+			}
+		}
+		//positions and scores change for everything in the new cache and for whatever fell out of it
+		for (size_t c = 0; c < newCache.size(); c++) {
+			uint32_t v = newCache[c];
+			cachePosition[v] = c < VERTEX_CACHE_SIZE ? (int)c : -1;
+			vertexScore[v] = getForsythScore(cachePosition[v], remaining[v]);
+		}
+		best = -1;
+		for (size_t c = 0; c < newCache.size(); c++) {
+			uint32_t v = newCache[c];
+			for (uint32_t j = 0; j < remaining[v]; j++) {
+				uint32_t t = vertexTriangles[triangleStart[v] + j];
+				triangleScore[t] = vertexScore[(*indices)[t * 3]] + vertexScore[(*indices)[t * 3 + 1]] + vertexScore[(*indices)[t * 3 + 2]];
+				if (c < VERTEX_CACHE_SIZE && (best < 0 || triangleScore[t] > triangleScore[best])) {
+					best = (int)t;
+				}
+			}
+		}
+		if (newCache.size() > VERTEX_CACHE_SIZE) {
+			newCache.resize(VERTEX_CACHE_SIZE);
+		}
+		cache.swap(newCache);
 	}
+	indices->swap(ordered);
+}
 
-	void createDescriptorPool() {
-		std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = 1;
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = 1;
-
-		VkDescriptorPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = poolSizes.size();
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = 1;
-
-		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, descriptorPool.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create descriptor pool!");
+//reorders a cache optimised mesh in clusters so the ones facing out from the model's centre come first, they hide more of the rest
+//clusters only end where the cache order restarts anyway (all three vertices missing) and the cluster so far is within threshold of the mesh's acmr,
+//so reordering them keeps the cache efficiency, like Sander et al.'s tipsify clustering
+void optimizeOverdraw(std::vector<uint32_t>* indices, const std::vector<Vertex>& vertices, float threshold = 1.05f) {
+	size_t triangleCount = indices->size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+	float meshAcmr = analyzeMesh(*indices, vertices.size(), sizeof(Vertex)).acmr;
+	std::vector<size_t> clusterStarts;
+	std::vector<uint32_t> cache;
+	size_t clusterMisses = 0;
+	for (size_t t = 0; t < triangleCount; t++) {
+		int misses = 0;
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = (*indices)[t * 3 + k];
+			if (std::find(cache.begin(), cache.end(), v) == cache.end()) {
+				misses++;
+				cache.insert(cache.begin(), v);
+				if (cache.size() > 16) {
+					cache.pop_back();
+				}
+			}
+		}
+		size_t clusterTriangles = clusterStarts.empty() ? 0 : t - clusterStarts.back();
+		if (clusterStarts.empty() || (misses == 3 && clusterMisses <= threshold * meshAcmr * clusterTriangles)) {
+			clusterStarts.push_back(t);
+			clusterMisses = 0;
 		}
+		clusterMisses += misses;
+	}
+	clusterStarts.push_back(triangleCount);
+
+	glm::vec3 meshCentre(0);
+	float meshArea = 0;
+	std::vector<std::pair<float, size_t>> clusterOrder;
+	std::vector<glm::vec3> clusterCentres;
+	std::vector<glm::vec3> clusterNormals;
+	for (size_t c = 0; c + 1 < clusterStarts.size(); c++) {
+		glm::vec3 centre(0);
+		glm::vec3 normal(0);
+		float area = 0;
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+			glm::vec3 a = vertices[(*indices)[t * 3]].pos;
+			glm::vec3 b = vertices[(*indices)[t * 3 + 1]].pos;
+			glm::vec3 d = vertices[(*indices)[t * 3 + 2]].pos;
+			glm::vec3 cross = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(cross);
+			centre += (a + b + d) / 3.0f * triangleArea;
+			normal += cross;
+			area += triangleArea;
+		}
+		meshCentre += centre;
+		meshArea += area;
+		clusterCentres.push_back(area > 0 ? centre / area : centre);
+		clusterNormals.push_back(glm::length(normal) > 0 ? glm::normalize(normal) : normal);
 	}
-
-	void createUniformBuffer() {
-		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformStagingBuffer, uniformStagingBufferMemory);
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, uniformBuffer, uniformBufferMemory);
+	if (meshArea > 0) {
+		meshCentre /= meshArea;
 	}
+	for (size_t c = 0; c < clusterCentres.size(); c++) {
+		clusterOrder.push_back(std::make_pair(-glm::dot(clusterCentres[c] - meshCentre, clusterNormals[c]), c));
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end());
 
-	void createDescriptorSetLayout() {
-		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.pImmutableSamplers = nullptr;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-		VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-		samplerLayoutBinding.binding = 1;
-		samplerLayoutBinding.descriptorCount = 1;
-		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		samplerLayoutBinding.pImmutableSamplers = nullptr;
-		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = bindings.size();
-		layoutInfo.pBindings = bindings.data();
+	std::vector<uint32_t> ordered;
+	ordered.reserve(indices->size());
+	for (size_t i = 0; i < clusterOrder.size(); i++) {
+		size_t c = clusterOrder[i].second;
+		ordered.insert(ordered.end(), indices->begin() + clusterStarts[c] * 3, indices->begin() + clusterStarts[c + 1] * 3);
+	}
+	indices->swap(ordered);
+}
 
-		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, descriptorSetLayout.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create descriptor set layout!");
+//renumbers vertices in the order the indices first use them so fetching walks the vertex buffer forwards, unused vertices are dropped
+//order[new vertex] is the old vertex, for the caller to move its vertices with
+void optimizeVertexFetch(std::vector<uint32_t>* indices, size_t vertexCount, std::vector<uint32_t>* order) {
+	std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+	order->clear();
+	for (size_t i = 0; i < indices->size(); i++) {
+		uint32_t& index = (*indices)[i];
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = (uint32_t)order->size();
+			order->push_back(index);
 		}
+		index = remap[index];
 	}
+}
 
-	//creating the index buffer
-	void createIndexBuffer(std::vector<uint32_t> _indices, VDeleter<VkBuffer>& _indexBuffer, VDeleter<VkDeviceMemory>& _indexBufferMemory) {
-		VkDeviceSize bufferSize = sizeof(_indices[0]) * _indices.size();
-
-		VDeleter<VkBuffer> stagingBuffer{ device, vkDestroyBuffer };
-		VDeleter<VkDeviceMemory> stagingBufferMemory{ device, vkFreeMemory };
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, _indices.data(), (size_t)bufferSize);
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexBuffer, _indexBufferMemory);
-
-		copyBuffer(stagingBuffer, _indexBuffer, bufferSize);
+//the three passes in the order they need, returns the vertex order for any other copies of the vertices
+void optimizeMesh(std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, std::vector<uint32_t>* order) {
+	optimizeVertexCache(indices, vertices->size());
+	optimizeOverdraw(indices, *vertices);
+	optimizeVertexFetch(indices, vertices->size(), order);
+	std::vector<Vertex> ordered(order->size());
+	for (size_t i = 0; i < order->size(); i++) {
+		ordered[i] = (*vertices)[(*order)[i]];
 	}
-	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VDeleter<VkBuffer>& buffer, VDeleter<VkDeviceMemory>& bufferMemory) {
-		VkBufferCreateInfo bufferInfo = {};
-		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = size;
-		bufferInfo.usage = usage;
-		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	vertices->swap(ordered);
+}
 
-		if (vkCreateBuffer(device, &bufferInfo, nullptr, buffer.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create buffer!");
-		}
+//turns chunks into triangles using the block models, kept apart from the vulkan side so meshing can run (and be timed) without a device
+class BlockMesher {
+public:
+	enum orientation {PX, NX, PY, NY, PZ, NZ};
+	//where one primitive's model sits in the buffers built by getPrimitiveGeometry
+	struct PrimitiveRange { uint32_t firstIndex; int32_t vertexOffset; uint32_t indexCount; };
 
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+	void loadPrimitives() {
+		loadPrimitive("andGate", "models/AndGate.obj", glm::vec3(0.5, 0.5, 0.9));
+		loadPrimitive("xorGate", "models/XorGate.obj", glm::vec3(0.5, 0.5, 0.9));
+		loadPrimitive("orGate", "models/OrGate.obj", glm::vec3(0.5, 0.5, 0.9));
+		loadPrimitive("wire", "models/wire2.obj", glm::vec3(0.9, 0.1, 0.1));
+		loadPrimitive("wire_center", "models/wire_center.obj", glm::vec3(0.7, 0.1, 0.1));
+		loadPrimitive("inverter", "models/inverter.obj", glm::vec3(0.1, 0.1, 0.9));
 
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+		typePrimitives[wire] = findPrimitive("wire");
+		typePrimitives[inverter] = findPrimitive("inverter");
+		typePrimitives[andGate] = findPrimitive("andGate");
+		typePrimitives[orGate] = findPrimitive("orGate");
+		typePrimitives[xorGate] = findPrimitive("xorGate");
+
+		//every wire shape is built once here, a lone wire keeps the bigger centre model
+		wireVariants[0] = findPrimitive("wire_center");
+		for (int mask = 1; mask < 64; mask++) {
+			wireVariants[mask] = primitives.size();
+			primitives.push_back(buildWireVariant(mask));
+		}
 
-		if (vkAllocateMemory(device, &allocInfo, nullptr, bufferMemory.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate buffer memory!");
+		//simplified versions for chunks far from the camera, a primitive that can't lose triangles is its own reduced version
+		int fullDetailCount = primitives.size();
+		reducedPrimitives.resize(fullDetailCount);
+		for (int i = 0; i < fullDetailCount; i++) {
+			reducedPrimitives[i] = i;
+			primitive reduced = reducePrimitive(primitives[i]);
+			if (reduced.indices.size() < primitives[i].indices.size()) {
+				reducedPrimitives[i] = primitives.size();
+				primitives.push_back(reduced);
+			}
 		}
 
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
+		for (size_t i = 0; i < primitives.size(); i++) {
+			optimizePrimitive(&primitives[i]);
+		}
+	}
+	//which primitive a block is drawn with and how it is turned
+	void getBlockPrimitive(const Block& block, uint8_t neighbours, bool reduced, int* primitiveIndex, orientation* primitiveOrientation) const {
+		if (block.type == wire) {
+			*primitiveIndex = wireVariants[neighbours];
+			*primitiveOrientation = PX;
+		}
+		else {
+			//gate models face against the block's direction
+			*primitiveIndex = typePrimitives[block.type];
+			*primitiveOrientation = (orientation)(block.direction ^ 1);
+		}
+		if (reduced) {
+			*primitiveIndex = reducedPrimitives[*primitiveIndex];
+		}
+	}
+	//triangles drawn for one primitive at full and at reduced detail
+	int getTriangleCount(int primitiveIndex, bool reduced) const {
+		return primitives[reduced ? reducedPrimitives[primitiveIndex] : primitiveIndex].indices.size() / 3;
+	}
+	int getPrimitiveCount() const {
+		return (int)primitives.size();
+	}
+	//every primitive's unrotated model back to back, uploaded once for the instanced pipeline
+	void getPrimitiveGeometry(std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, std::vector<PrimitiveRange>* ranges) const {
+		for (size_t i = 0; i < primitives.size(); i++) {
+			PrimitiveRange range;
+			range.firstIndex = indices->size();
+			range.vertexOffset = vertices->size();
+			range.indexCount = primitives[i].indices.size();
+			ranges->push_back(range);
+			vertices->insert(vertices->end(), primitives[i].verticesPX.begin(), primitives[i].verticesPX.end());
+			indices->insert(indices->end(), primitives[i].indices.begin(), primitives[i].indices.end());
+		}
+	}
+	//the instanced version of meshChunk, one record per primitive meshChunk would have copied
+	//instances come out grouped by primitive, instanceCounts[primitive] says how many are in each group
+	void instanceChunk(const Chunk& chunk, std::vector<BlockInstance>* instances, std::vector<uint32_t>* instanceCounts, bool reduced = false) const {
+		std::vector<std::pair<int, BlockInstance>> placed;
+		instanceCounts->assign(primitives.size(), 0);
+		for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+			if (!chunk.occupied[cell]) {
+				continue;
+			}
+			Block block = chunk.getBlock(cell);
+			int primitiveIndex;
+			orientation primitiveOrientation;
+			getBlockPrimitive(block, chunk.neighbours[cell], reduced, &primitiveIndex, &primitiveOrientation);
+			BlockInstance instance;
+			instance.position = block.position;
+			instance.orientation = primitiveOrientation;
+			placed.push_back(std::make_pair(primitiveIndex, instance));
+		}
+		std::vector<uint32_t> offsets(primitives.size(), (uint32_t)instances->size());
+		for (size_t i = 0; i < placed.size(); i++) {
+			(*instanceCounts)[placed[i].first]++;
+		}
+		for (size_t p = 1; p < primitives.size(); p++) {
+			offsets[p] = offsets[p - 1] + (*instanceCounts)[p - 1];
+		}
+		instances->resize(instances->size() + placed.size());
+		for (size_t i = 0; i < placed.size(); i++) {
+			(*instances)[offsets[placed[i].first]++] = placed[i].second;
+		}
+	}
+	//appends the geometry of every block in the chunk, wire shapes come from the chunk's neighbour masks so no lookups are needed
+	//reduced swaps in the simplified primitives for chunks far from the camera
+	void meshChunk(const Chunk& chunk, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices, bool reduced = false) {
+		for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+			if (!chunk.occupied[cell]) {
+				continue;
+			}
+			Block block = chunk.getBlock(cell);
+			int primitiveIndex;
+			orientation primitiveOrientation;
+			getBlockPrimitive(block, chunk.neighbours[cell], reduced, &primitiveIndex, &primitiveOrientation);
+			addPrimitive(primitiveIndex, block.position, primitiveOrientation, vertices, indices);
+		}
+	}
+	//overview mode, every block is a solid cube coloured by its type
+	//faces against another block are dropped using the neighbour masks and the rest are greedy merged per type, so a dense circuit comes out as a few big quads per chunk
+	void meshChunkBoxes(const Chunk& chunk, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices) const {
+		static const glm::vec3 boxColours[5] = { glm::vec3(0.9, 0.1, 0.1), glm::vec3(0.1, 0.1, 0.9), glm::vec3(0.5, 0.5, 0.9), glm::vec3(0.5, 0.5, 0.9), glm::vec3(0.5, 0.5, 0.9) };
+		//each direction gets its own brightness so the edges between merged faces still show
+		static const float faceShades[6] = { 0.8f, 0.8f, 1.0f, 0.5f, 0.65f, 0.65f };
+		uint8_t grid[CHUNK_SIZE * CHUNK_SIZE];
+		std::vector<GreedyRect> rects;
+		for (int n = 0; n < 6; n++) {
+			//blockDirection goes positive then negative along x, y and z
+			int a = n / 2;
+			int side = (n & 1) ? -1 : 1;
+			int u = (a + 1) % 3;
+			int v = (a + 2) % 3;
+			for (int slice = 0; slice < CHUNK_SIZE; slice++) {
+				for (int j = 0; j < CHUNK_SIZE; j++) {
+					for (int i = 0; i < CHUNK_SIZE; i++) {
+						glm::ivec3 local;
+						local[a] = slice;
+						local[u] = i;
+						local[v] = j;
+						int cell = chunkCell(local.x, local.y, local.z);
+						bool exposed = chunk.occupied[cell] && !(chunk.neighbours[cell] & (1 << n));
+						grid[j * CHUNK_SIZE + i] = exposed ? (chunk.cells[cell] >> 3) + 1 : 0;
+					}
+				}
+				rects.clear();
+				greedyMerge(grid, CHUNK_SIZE, CHUNK_SIZE, &rects);
+				for (size_t r = 0; r < rects.size(); r++) {
+					//corners go anticlockwise seen from the side the face points to, like the models
+					glm::ivec2 corners[4] = {
+						glm::ivec2(rects[r].x, rects[r].y), glm::ivec2(rects[r].x + rects[r].width, rects[r].y),
+						glm::ivec2(rects[r].x + rects[r].width, rects[r].y + rects[r].height), glm::ivec2(rects[r].x, rects[r].y + rects[r].height)
+					};
+					if (side < 0) {
+						std::swap(corners[1], corners[3]);
+					}
+					uint32_t first = vertices->size();
+					for (int c = 0; c < 4; c++) {
+						Vertex vertex = {};
+						glm::ivec3 pos;
+						pos[a] = side > 0 ? slice + 1 : slice;
+						pos[u] = corners[c].x;
+						pos[v] = corners[c].y;
+						vertex.pos = glm::vec3(chunk.origin + pos);
+						vertex.color = boxColours[rects[r].value - 1] * faceShades[n];
+						vertex.texCoord = { 0, 0 };
+						vertices->push_back(vertex);
+					}
+					uint32_t quadIndices[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+					indices->insert(indices->end(), quadIndices, quadIndices + 6);
+				}
+			}
+		}
+	}
+	void addPrimitive(std::string name, glm::vec3 offset, orientation _orientation, std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
+		for (int i = 0; i < primitives.size(); i++) {
+			if (primitives[i].name == name) {
+				addVectorsWithOffset(_vertices, _indices, getOrientedVertices(&primitives[i], _orientation), &primitives[i].indices, offset);
+			}
+		}
+	}
+	static std::vector<Vertex>* getOrientedVertices(primitive* _primitive, orientation _orientation) {
+		switch (_orientation) {
+		case NX:
+			return &_primitive->verticesNX;
+		case PY:
+			return &_primitive->verticesPY;
+		case NY:
+			return &_primitive->verticesNY;
+		case PZ:
+			return &_primitive->verticesPZ;
+		case NZ:
+			return &_primitive->verticesNZ;
+		default:
+			return &_primitive->verticesPX;
+		}
+	}
+	void addPrimitive(int index, glm::vec3 offset, orientation _orientation, std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
+		addVectorsWithOffset(_vertices, _indices, getOrientedVertices(&primitives[index], _orientation), &primitives[index].indices, offset);
+	}
+	void addPrimitive(std::string name, glm::vec3 offset, std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices) {
+		for (int i = 0; i < primitives.size(); i++) {
+			if (primitives[i].name == name) {
+				addVectorsWithOffset(_vertices, _indices, &primitives[i].verticesPX, &primitives[i].indices, offset);
+			}
+		}
 	}
 
-	void createVertexBuffer(std::vector<Vertex> _vertices, VDeleter<VkBuffer>& _vertexBuffer, VDeleter<VkDeviceMemory>& _vertexBufferMemory) {
-		VkDeviceSize bufferSize = sizeof(_vertices[0]) * _vertices.size();
-
-		VDeleter<VkBuffer> stagingBuffer{ device, vkDestroyBuffer };
-		VDeleter<VkDeviceMemory> stagingBufferMemory{ device, vkFreeMemory };
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, _vertices.data(), (size_t)bufferSize);
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vertexBuffer, _vertexBufferMemory);
-
-		copyBuffer(stagingBuffer, _vertexBuffer, bufferSize);
+	 void loadPrimitive(std::string name, std::string path, glm::vec3 colour) {
+		primitive temp;
+		loadModel(&temp.verticesPX, &temp.indices, path, colour);
+		temp.name = name;
+		temp = rotatePrimitive(temp);
+		primitives.push_back(temp);
+	}
+	 //each orientation is the positive x model turned about the block's centre, one batch transform per orientation
+	 primitive rotatePrimitive(primitive _primitive) const {
+		 float PI = 3.1415926;
+		 std::vector<Vertex>* turned[5] = { &_primitive.verticesNX, &_primitive.verticesPZ, &_primitive.verticesNZ, &_primitive.verticesPY, &_primitive.verticesNY };
+		 float angles[5] = { PI, PI * 1.5f, PI / 2, PI / 2, PI * 1.5f };
+		 glm::vec3 axes[5] = { glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, 1) };
+		 PositionStream positions;
+		 positions.load(_primitive.verticesPX);
+		 PositionStream rotated;
+		 for (int i = 0; i < 5; i++) {
+			 *turned[i] = _primitive.verticesPX;
+			 rotatePositions(positions, &rotated, angles[i], axes[i], glm::vec3(0.5, 0.5, 0.5));
+			 rotated.store(turned[i]);
+		 }
+		 return _primitive;
 	}
+	void loadModel(std::vector<Vertex>* _vertices, std::vector<uint32_t>* _indices, std::string path, glm::vec3 colour) {
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string err;
 
-	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str())) {
+			throw std::runtime_error(err);
+		}
 
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+		std::unordered_map<Vertex, int> uniqueVertices = {};
+		//the colour jitter is picked once per model vertex so the faces around it can share it
+		std::unordered_map<int, glm::vec3> vertexColours;
 
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		for (const auto& shape : shapes) {
+			for (const auto& index : shape.mesh.indices) {
+				Vertex vertex = {};
 
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+				vertex.pos = {
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2]
+				};
 
-		VkBufferCopy copyRegion = {};
-		copyRegion.srcOffset = 0; // Optional
-		copyRegion.dstOffset = 0; // Optional
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+				vertex.texCoord = {0,0};// {attrib.texcoords[2 * index.texcoord_index + 0],1.0f - attrib.texcoords[2 * index.texcoord_index + 1]};
 
-		vkEndCommandBuffer(commandBuffer);
+				auto colourIt = vertexColours.find(index.vertex_index);
+				if (colourIt == vertexColours.end()) {
+					glm::vec3 jittered = { colour.r -0.2 + 0.4*((double)rand() / (RAND_MAX)), colour.g - 0.2 + 0.4*((double)rand() / (RAND_MAX)), colour.b - 0.2 + 0.4*((double)rand() / (RAND_MAX)) };
+					colourIt = vertexColours.emplace(index.vertex_index, jittered).first;
+				}
+				vertex.color = colourIt->second;
 
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
+				if (uniqueVertices.count(vertex) == 0) {
+					uniqueVertices[vertex] = _vertices->size();
+					_vertices->push_back(vertex);
+				}
 
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue);
+				_indices->push_back(uniqueVertices[vertex]);
+			}
+		}
 
-		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 	}
-	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
 
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+private:
+	std::vector<primitive> primitives;
+	int typePrimitives[5];
+	//primitive index for each 6 bit neighbour mask
+	int wireVariants[64];
+	//primitive index of the simplified version of each primitive
+	std::vector<int> reducedPrimitives;
+
+	int findPrimitive(const std::string& name) const {
+		for (int i = 0; i < (int)primitives.size(); i++) {
+			if (primitives[i].name == name) {
 				return i;
 			}
 		}
-
-		throw std::runtime_error("failed to find suitable memory type!");
+		throw std::runtime_error("failed to find primitive " + name + "!");
+	}
+	//a junction is the union of the arm boxes towards its neighbours, so its surface is found exactly by cutting the block at every box side
+	//and greedy merging the cell faces that have a filled cell behind them and an empty one in front, no faces end up inside the wire
+	primitive buildWireVariant(int mask) const {
+		const primitive& arm = primitives[typePrimitives[wire]];
+		const std::vector<Vertex>* armVertices[6] = { &arm.verticesPX, &arm.verticesNX, &arm.verticesPY, &arm.verticesNY, &arm.verticesPZ, &arm.verticesNZ };
+		std::vector<glm::vec3> boxMins;
+		std::vector<glm::vec3> boxMaxes;
+		std::vector<float> cuts[3];
+		for (int n = 0; n < 6; n++) {
+			if (!(mask & (1 << n))) {
+				continue;
+			}
+			//the models are a hair off the block grid, snapping stops that from leaving slivers between arms
+			glm::vec3 boxMin(FLT_MAX);
+			glm::vec3 boxMax(-FLT_MAX);
+			for (size_t i = 0; i < armVertices[n]->size(); i++) {
+				glm::vec3 pos = glm::round((*armVertices[n])[i].pos * 1000.0f) / 1000.0f;
+				boxMin = glm::min(boxMin, pos);
+				boxMax = glm::max(boxMax, pos);
+			}
+			boxMins.push_back(boxMin);
+			boxMaxes.push_back(boxMax);
+			for (int a = 0; a < 3; a++) {
+				cuts[a].push_back(boxMin[a]);
+				cuts[a].push_back(boxMax[a]);
+			}
+		}
+		glm::ivec3 cellCount;
+		for (int a = 0; a < 3; a++) {
+			std::sort(cuts[a].begin(), cuts[a].end());
+			cuts[a].erase(std::unique(cuts[a].begin(), cuts[a].end()), cuts[a].end());
+			cellCount[a] = cuts[a].size() - 1;
+		}
+		auto isFilled = [&](glm::ivec3 cell) {
+			for (int a = 0; a < 3; a++) {
+				if (cell[a] < 0 || cell[a] >= cellCount[a]) {
+					return false;
+				}
+			}
+			glm::vec3 centre;
+			for (int a = 0; a < 3; a++) {
+				centre[a] = (cuts[a][cell[a]] + cuts[a][cell[a] + 1]) / 2;
+			}
+			for (size_t b = 0; b < boxMins.size(); b++) {
+				if (glm::all(glm::greaterThan(centre, boxMins[b])) && glm::all(glm::lessThan(centre, boxMaxes[b]))) {
+					return true;
+				}
+			}
+			return false;
+		};
+
+		primitive variant;
+		variant.name = "wire_" + std::to_string(mask);
+		std::unordered_map<Vertex, int> uniqueVertices;
+		std::vector<uint8_t> grid;
+		std::vector<GreedyRect> rects;
+		for (int a = 0; a < 3; a++) {
+			int u = (a + 1) % 3;
+			int v = (a + 2) % 3;
+			for (int side = 1; side >= -1; side -= 2) {
+				for (int slice = 0; slice < cellCount[a]; slice++) {
+					grid.assign(cellCount[u] * cellCount[v], 0);
+					for (int j = 0; j < cellCount[v]; j++) {
+						for (int i = 0; i < cellCount[u]; i++) {
+							glm::ivec3 cell;
+							cell[a] = slice;
+							cell[u] = i;
+							cell[v] = j;
+							glm::ivec3 front = cell;
+							front[a] += side;
+							grid[j * cellCount[u] + i] = isFilled(cell) && !isFilled(front);
+						}
+					}
+					rects.clear();
+					greedyMerge(grid.data(), cellCount[u], cellCount[v], &rects);
+					for (size_t r = 0; r < rects.size(); r++) {
+						//corners go anticlockwise seen from the side the face points to, like the models
+						glm::vec2 corners[4] = {
+							glm::vec2(rects[r].x, rects[r].y), glm::vec2(rects[r].x + rects[r].width, rects[r].y),
+							glm::vec2(rects[r].x + rects[r].width, rects[r].y + rects[r].height), glm::vec2(rects[r].x, rects[r].y + rects[r].height)
+						};
+						if (side < 0) {
+							std::swap(corners[1], corners[3]);
+						}
+						uint32_t quad[4];
+						for (int c = 0; c < 4; c++) {
+							Vertex vertex = {};
+							vertex.pos[a] = cuts[a][side > 0 ? slice + 1 : slice];
+							vertex.pos[u] = cuts[u][(int)corners[c].x];
+							vertex.pos[v] = cuts[v][(int)corners[c].y];
+							vertex.texCoord = { 0, 0 };
+							vertex.color = getNearestColour(armVertices, mask, vertex.pos);
+							if (uniqueVertices.count(vertex) == 0) {
+								uniqueVertices[vertex] = variant.verticesPX.size();
+								variant.verticesPX.push_back(vertex);
+							}
+							quad[c] = uniqueVertices[vertex];
+						}
+						uint32_t quadIndices[6] = { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] };
+						variant.indices.insert(variant.indices.end(), quadIndices, quadIndices + 6);
+					}
+				}
+			}
+		}
+		return variant;
+	}
+	//reorders one primitive for the vertex cache, overdraw and vertex fetch, every orientation's vertices move the same way
+	static void optimizePrimitive(primitive* _primitive) {
+		std::vector<uint32_t> order;
+		optimizeMesh(&_primitive->verticesPX, &_primitive->indices, &order);
+		std::vector<Vertex>* turned[5] = { &_primitive->verticesNX, &_primitive->verticesPY, &_primitive->verticesNY, &_primitive->verticesPZ, &_primitive->verticesNZ };
+		for (int i = 0; i < 5; i++) {
+			if (turned[i]->empty()) {
+				continue;
+			}
+			std::vector<Vertex> ordered(order.size());
+			for (size_t v = 0; v < order.size(); v++) {
+				ordered[v] = (*turned[i])[order[v]];
+			}
+			turned[i]->swap(ordered);
+		}
 	}
-
-	//re-creating the swap chain for when it becomes incompatible, like when the window is resized
-	void recreateSwapChain() {
-		vkDeviceWaitIdle(device);
-
-		createSwapChain();
-		createImageViews();
-		createRenderPass();
-		createGraphicsPipeline();
-		createDepthResources();
-		createFramebuffers();
-		createCommandBuffers();
+	//half the triangles, as long as no collapse moves the surface by more than 3% of a block, which is under a pixel where reduced detail is used
+	primitive reducePrimitive(const primitive& source) const {
+		primitive reduced;
+		reduced.name = source.name + "_reduced";
+		decimateMesh(source.verticesPX, source.indices, source.indices.size() / 6, 0.03f, &reduced.verticesPX, &reduced.indices);
+		//wire shapes are never turned so they only have the one copy
+		if (!source.verticesNX.empty()) {
+			reduced = rotatePrimitive(reduced);
+		}
+		return reduced;
+	}
+	//built junctions take the colour of the closest arm vertex so they keep the models' shading
+	static glm::vec3 getNearestColour(const std::vector<Vertex>* const* armVertices, int mask, glm::vec3 pos) {
+		glm::vec3 colour;
+		float nearest = FLT_MAX;
+		for (int n = 0; n < 6; n++) {
+			if (!(mask & (1 << n))) {
+				continue;
+			}
+			for (size_t i = 0; i < armVertices[n]->size(); i++) {
+				float distance = glm::length((*armVertices[n])[i].pos - pos);
+				if (distance < nearest) {
+					nearest = distance;
+					colour = (*armVertices[n])[i].color;
+				}
+			}
+		}
+		return colour;
 	}
+};
 
-	void createSemaphores() {
-		VkSemaphoreCreateInfo semaphoreInfo = {};
-		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, imageAvailableSemaphore.replace()) != VK_SUCCESS ||
-			vkCreateSemaphore(device, &semaphoreInfo, nullptr, renderFinishedSemaphore.replace()) != VK_SUCCESS) {
-
-			throw std::runtime_error("failed to create semaphores!");
+//fixed set of worker threads, each with its own task queue
+//a worker runs its own newest task first and, when its queue is empty, steals the oldest task from another worker
+class WorkStealingPool {
+public:
+	WorkStealingPool(int threadCount) : queues(std::max(threadCount, 1)) {
+		for (int i = 0; i < (int)queues.size(); i++) {
+			workers.emplace_back([this, i]() { run(i); });
 		}
 	}
-	//allocates and records commands for every swapchain image
-	void createCommandBuffers() {
-		if (commandBuffers.size() > 0) {
-			//vkFreeCommandBuffers(device, commandPool, commandBuffers.size(), commandBuffers.data());
+	~WorkStealingPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
 		}
-
-		commandBuffers.resize(swapChainFramebuffers.size());
-
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
-
-		if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate command buffers!");
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); i++) {
+			workers[i].join();
 		}
-
-		for (size_t i = 0; i < commandBuffers.size(); i++) {
-			VkCommandBufferBeginInfo beginInfo = {};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-
-			vkBeginCommandBuffer(commandBuffers[i], &beginInfo);
-
-			VkRenderPassBeginInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = renderPass;
-			renderPassInfo.framebuffer = swapChainFramebuffers[i];
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = swapChainExtent;
-
-			std::array<VkClearValue, 2> clearValues = {};
-			clearValues[0].color = { 0.9f, 0.9f, 0.9f, 1.0f };
-			clearValues[1].depthStencil = { 1.0f, 0 };
-
-			renderPassInfo.clearValueCount = clearValues.size();
-			renderPassInfo.pClearValues = clearValues.data();
-
-			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-			vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-
-			//ADD MORE VERTEX BUFFERS HERE
-			VkBuffer vertexBuffers[] = { vertexBuffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-
-			vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-			vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
-
-			vkCmdDrawIndexed(commandBuffers[i], indices.size(), 1, 0, 0, 0);
-
-			vkCmdEndRenderPass(commandBuffers[i]);
-
-			if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-				throw std::runtime_error("failed to record command buffer!");
+	}
+	void submit(std::function<void()> task) {
+		//counted first so wait() can't see zero while the task is on its way into a queue
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending++;
+			queued++;
+		}
+		TaskQueue& queue = queues[nextQueue++ % queues.size()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+		}
+		wake.notify_one();
+	}
+	//blocks until every submitted task has finished
+	void wait() {
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this]() { return pending == 0; });
+	}
+	bool isIdle() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending == 0;
+	}
+	int getThreadCount() const {
+		return (int)workers.size();
+	}
+private:
+	struct TaskQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+	std::vector<TaskQueue> queues;
+	std::vector<std::thread> workers;
+	std::atomic<unsigned> nextQueue{ 0 };
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	int pending = 0;
+	int queued = 0;
+	bool stopping = false;
+
+	bool takeTask(int index, std::function<void()>* task) {
+		for (size_t i = 0; i < queues.size(); i++) {
+			TaskQueue& queue = queues[(index + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty()) {
+				continue;
+			}
+			if (i == 0) {
+				*task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
 			}
+			else {
+				*task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+			return true;
 		}
+		return false;
 	}
-	//manages the memory that is used to store command buffers
-	void createCommandPool() {
-		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
-
-		VkCommandPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-		poolInfo.flags = 0; // Optional
-
-		if (vkCreateCommandPool(device, &poolInfo, nullptr, commandPool.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create command pool!");
+	void run(int index) {
+		while (true) {
+			std::function<void()> task;
+			if (takeTask(index, &task)) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					queued--;
+				}
+				task();
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--pending == 0) {
+					done.notify_all();
+				}
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return stopping || queued > 0; });
+			if (stopping && queued == 0) {
+				return;
+			}
 		}
 	}
+};
 
-	void createFramebuffers() {
-		swapChainFramebuffers.resize(swapChainImageViews.size(), VDeleter<VkFramebuffer>{device, vkDestroyFramebuffer});
+//how much of a chunk is drawn, the simplified primitives or just boxes once its blocks are a few pixels across
+enum detailLevel { fullDetail, reducedDetail, boxDetail };
+const float REDUCED_DETAIL_PIXELS = 8.0f;
+const float BOX_DETAIL_PIXELS = 2.5f;
 
-		for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-			std::array<VkImageView, 2> attachments = {
-				swapChainImageViews[i],
-				depthImageView
-			};
+//picks a chunk's detail from how many pixels one of its blocks covers at the chunk's nearest point to the camera
+//projectionScale is the viewport height over 2 tan(fov / 2), a block at distance d is about projectionScale / d pixels tall
+detailLevel chooseChunkDetail(const Chunk& chunk, glm::vec3 camera, float projectionScale) {
+	glm::vec3 nearest = glm::clamp(camera, glm::vec3(chunk.origin), glm::vec3(chunk.origin + CHUNK_SIZE));
+	float blockPixels = projectionScale / std::max(glm::length(camera - nearest), 0.001f);
+	if (blockPixels < BOX_DETAIL_PIXELS) {
+		return boxDetail;
+	}
+	if (blockPixels < REDUCED_DETAIL_PIXELS) {
+		return reducedDetail;
+	}
+	return fullDetail;
+}
 
-			VkFramebufferCreateInfo framebufferInfo = {};
-			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebufferInfo.renderPass = renderPass;
-			framebufferInfo.attachmentCount = attachments.size();
-			framebufferInfo.pAttachments = attachments.data();
-			framebufferInfo.width = swapChainExtent.width;
-			framebufferInfo.height = swapChainExtent.height;
-			framebufferInfo.layers = 1;
+//geometry for one chunk built off the render thread, request orders the meshes of the same chunk
+struct MeshedChunk {
+	uint64_t key;
+	uint64_t request;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<BlockInstance> instances;
+	std::vector<uint32_t> instanceCounts;
+	//vertices end up here instead when the mesher packs them
+	std::vector<PackedVertex> packedVertices;
+	glm::ivec3 origin;
+	//indices end up here instead when the mesh splits into 16 bit sections
+	std::vector<uint16_t> shortIndices;
+	std::vector<IndexSection> sections;
+};
 
-			if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, swapChainFramebuffers[i].replace()) != VK_SUCCESS) {
-				throw std::runtime_error("failed to create framebuffer!");
+//meshes chunks from an immutable snapshot on the pool so edits can carry on while it works
+//finished meshes collect in one list while the render thread owns the other, takeCompleted swaps them
+class ParallelMesher {
+public:
+	ParallelMesher(BlockMesher* _mesher, int threadCount) : pool(threadCount) { mesher = _mesher; }
+
+	//copied block models, instance records for the instanced pipeline, or the box overview
+	enum meshStyle { copiedMesh, instancedMesh, boxMesh };
+	//copied and box meshes are turned into PackedVertex on the mesher threads, set before the first meshChunks call
+	bool packed = false;
+
+	//called from the render thread, reduced picks the simplified primitives for the models
+	void meshChunks(std::shared_ptr<const BlockSnapshot> snapshot, const std::vector<uint64_t>& keys, meshStyle style, bool reduced = false) {
+		for (size_t i = 0; i < keys.size(); i++) {
+			uint64_t key = keys[i];
+			uint64_t request = ++requestCount;
+			latestRequests[key] = request;
+			pool.submit([this, snapshot, key, request, style, reduced]() {
+				MeshedChunk meshed;
+				meshed.key = key;
+				meshed.request = request;
+				auto it = snapshot->chunks.find(key);
+				if (it != snapshot->chunks.end()) {
+					switch (style) {
+					case copiedMesh:
+						mesher->meshChunk(*it->second, &meshed.vertices, &meshed.indices, reduced);
+						break;
+					case instancedMesh:
+						mesher->instanceChunk(*it->second, &meshed.instances, &meshed.instanceCounts, reduced);
+						break;
+					case boxMesh:
+						mesher->meshChunkBoxes(*it->second, &meshed.vertices, &meshed.indices);
+						break;
+					}
+					if (packed && !meshed.vertices.empty()) {
+						meshed.origin = it->second->origin;
+						meshed.packedVertices.resize(meshed.vertices.size());
+						for (size_t v = 0; v < meshed.vertices.size(); v++) {
+							meshed.packedVertices[v] = PackedVertex::pack(meshed.vertices[v], meshed.origin);
+						}
+						std::vector<Vertex>().swap(meshed.vertices);
+					}
+					if (!meshed.indices.empty()) {
+						if (splitShortIndices(meshed.indices, &meshed.shortIndices, &meshed.sections)) {
+							std::vector<uint32_t>().swap(meshed.indices);
+						}
+						else {
+							IndexSection whole = { 0, (uint32_t)meshed.indices.size(), 0 };
+							meshed.sections.push_back(whole);
+						}
+					}
+				}
+				std::lock_guard<std::mutex> lock(completedMutex);
+				completed.push_back(std::move(meshed));
+			});
+		}
+	}
+	//called from the render thread, hands over every mesh finished since the last call
+	//a mesh is dropped if the same chunk was requested again after it, the newer request's mesh is still coming
+	void takeCompleted(std::vector<MeshedChunk>* meshes) {
+		meshes->clear();
+		{
+			std::lock_guard<std::mutex> lock(completedMutex);
+			completed.swap(*meshes);
+		}
+		size_t kept = 0;
+		for (size_t i = 0; i < meshes->size(); i++) {
+			auto it = latestRequests.find((*meshes)[i].key);
+			if (it == latestRequests.end() || it->second != (*meshes)[i].request) {
+				continue;
 			}
+			latestRequests.erase(it);
+			if (kept != i) {
+				(*meshes)[kept] = std::move((*meshes)[i]);
+			}
+			kept++;
 		}
+		meshes->resize(kept);
+	}
+	//chunks requested whose newest mesh hasn't been taken yet
+	int getPendingCount() const {
+		return (int)latestRequests.size();
+	}
+	void wait() {
+		pool.wait();
+	}
+	int getThreadCount() const {
+		return pool.getThreadCount();
 	}
+private:
+	BlockMesher* mesher;
+	std::mutex completedMutex;
+	std::vector<MeshedChunk> completed;
+	uint64_t requestCount = 0;
+	std::unordered_map<uint64_t, uint64_t> latestRequests;
+	//last so its threads are joined before anything they use goes away
+	WorkStealingPool pool;
+};
 
-	void createRenderPass() {
-		VkAttachmentDescription colorAttachment = {};
-		colorAttachment.format = swapChainImageFormat;
-		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+class WorkSpace {
+public:
+	void run() {
+		initWindow();
+		blocks.init(&vertices, &indices);
+		//drawBlocks();
+		initVulkan();
 
-		VkAttachmentDescription depthAttachment = {};
-		depthAttachment.format = findDepthFormat();
-		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		mainLoop();
+		stagingRing.release();
+		stagingRing.printStats(std::cout);
+		memoryAllocator.printStats(std::cout);
+	}
+	
+private:
+	GLFWwindow* window;
 
-		VkAttachmentReference colorAttachmentRef = {};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	VDeleter<VkInstance> instance{ vkDestroyInstance };
+	VDeleter<VkDebugReportCallbackEXT> callback{ instance, DestroyDebugReportCallbackEXT };
+	VDeleter<VkSurfaceKHR> surface{ instance, vkDestroySurfaceKHR };
 
-		VkAttachmentReference depthAttachmentRef = {};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VDeleter<VkDevice> device{ vkDestroyDevice };
+	//every buffer and image takes its memory from here, declared after the device and before anything holding memory so it is torn down in between
+	DeviceMemoryAllocator memoryAllocator;
 
-		VkSubpassDescription subpass = {};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
-		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+	VkQueue graphicsQueue;
+	VkQueue presentQueue;
+	VkQueue transferQueue = VK_NULL_HANDLE;
 
-		VkSubpassDependency dependency = {};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	VDeleter<VkSwapchainKHR> swapChain{ device, vkDestroySwapchainKHR };
+	std::vector<VkImage> swapChainImages;
+	VkFormat swapChainImageFormat;
+	VkExtent2D swapChainExtent;
+	std::vector<VDeleter<VkImageView>> swapChainImageViews;
+	std::vector<VDeleter<VkFramebuffer>> swapChainFramebuffers;
 
-		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
-		VkRenderPassCreateInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = attachments.size();
-		renderPassInfo.pAttachments = attachments.data();
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
+	VDeleter<VkRenderPass> renderPass{ device, vkDestroyRenderPass };
+	VDeleter<VkDescriptorSetLayout> descriptorSetLayout{ device, vkDestroyDescriptorSetLayout };
+	VDeleter<VkPipelineLayout> pipelineLayout{ device, vkDestroyPipelineLayout };
+	VDeleter<VkPipeline> graphicsPipeline{ device, vkDestroyPipeline };
+	VDeleter<VkPipeline> instancedPipeline{ device, vkDestroyPipeline };
+	VDeleter<VkPipeline> packedPipeline{ device, vkDestroyPipeline };
 
-		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, renderPass.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create render pass!");
-		}
-	}
+	VDeleter<VkCommandPool> commandPool{ device, vkDestroyCommandPool };
+	VDeleter<VkCommandPool> transferCommandPool{ device, vkDestroyCommandPool };
+	//declared after the pools so the ring waits for its copies and frees its command buffers first
+	VDeleter<VkBuffer> stagingRingBuffer{ device, vkDestroyBuffer };
+	DeviceMemory stagingRingMemory{ memoryAllocator };
+	StagingRing stagingRing;
 
-	void createGraphicsPipeline() {
-		//loading vertex and fragment shaders
-		auto vertShaderCode = readFile("shaders/vert.spv");
-		auto fragShaderCode = readFile("shaders/frag.spv");
-		//only required in the pipeling creation proccess, so defined here instead of as a property of this class
-		VDeleter<VkShaderModule> vertShaderModule{ device, vkDestroyShaderModule };
-		VDeleter<VkShaderModule> fragShaderModule{ device, vkDestroyShaderModule };
+	VDeleter<VkImage> textureImage{ device, vkDestroyImage };
+	DeviceMemory textureImageMemory{ memoryAllocator };
+	VDeleter<VkImageView> textureImageView{ device, vkDestroyImageView };
+	VDeleter<VkSampler> textureSampler{ device, vkDestroySampler };
 
-		createShaderModule(vertShaderCode, vertShaderModule);
-		createShaderModule(fragShaderCode, fragShaderModule);
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
 
-		VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	VDeleter<VkBuffer> vertexBuffer{ device, vkDestroyBuffer };
+	DeviceMemory vertexBufferMemory{ memoryAllocator };
+	VDeleter<VkBuffer> indexBuffer{ device, vkDestroyBuffer };
+	DeviceMemory indexBufferMemory{ memoryAllocator };
+
+	//chunk meshes are drawn from PackedVertex with shaders/packed.spv
+	bool packedRendering = true;
+	//every primitive's model, uploaded once and drawn instanced for each chunk
+	bool instancedRendering = true;
+	std::vector<BlockMesher::PrimitiveRange> primitiveRanges;
+	VDeleter<VkBuffer> primitiveVertexBuffer{ device, vkDestroyBuffer };
+	DeviceMemory primitiveVertexBufferMemory{ memoryAllocator };
+	//16 bit, each primitive's indices are relative to its own vertexOffset and no block model comes near 65536 vertices
+	VDeleter<VkBuffer> primitiveIndexBuffer{ device, vkDestroyBuffer };
+	DeviceMemory primitiveIndexBufferMemory{ memoryAllocator };
+	//every copied and box chunk mesh lives in one of these, pages are kept once made and refilled as chunks are meshed again
+	std::vector<std::unique_ptr<ChunkPage>> chunkPages;
+
+	//host visible and mapped for good, a slot per swap chain image picked with a dynamic offset, so a frame's uniforms are a memcpy
+	VDeleter<VkBuffer> uniformBuffer{ device, vkDestroyBuffer };
+	DeviceMemory uniformBufferMemory{ memoryAllocator };
+	VkDeviceSize uniformSlotSize = 0;
+	//filled in by updateUniformBuffer, copied into the acquired image's slot by drawFrame
+	UniformBufferObject frameUniforms = {};
+	//the fence of the frame that last drew each swap chain image, that image's uniform slot can be written once it is signalled
+	std::vector<VkFence> imageFences;
 
-		vertShaderStageInfo.module = vertShaderModule;
-		vertShaderStageInfo.pName = "main";
+	VDeleter<VkDescriptorPool> descriptorPool{ device, vkDestroyDescriptorPool };
+	VkDescriptorSet descriptorSet;
 
-		VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfo.module = fragShaderModule;
-		fragShaderStageInfo.pName = "main";
+	std::vector<VkCommandBuffer> commandBuffers;
+	//command buffers replaced by a new recording while each frame was being prepared, freed along with that frame's retired meshes
+	std::array<std::vector<VkCommandBuffer>, MAX_FRAMES_IN_FLIGHT> retiredCommandBuffers;
 
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+	//one of each per frame in flight, currentFrame picks the set the frame being prepared uses
+	std::vector<VDeleter<VkSemaphore>> imageAvailableSemaphores;
+	std::vector<VDeleter<VkSemaphore>> renderFinishedSemaphores;
+	//signalled when that frame has been drawn
+	std::vector<VDeleter<VkFence>> frameFences;
+	size_t currentFrame = 0;
 
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	VDeleter<VkImage> depthImage{ device, vkDestroyImage };
+	DeviceMemory depthImageMemory{ memoryAllocator };
 
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	VDeleter<VkImageView> depthImageView{ device, vkDestroyImageView };
+	Blocks blocks;
+	BlockQueries queries = BlockQueries(&blocks);
+	//chunk key -> gpu buffers for that chunk's geometry
+	std::unordered_map<uint64_t, std::unique_ptr<ChunkMesh>> chunkMeshes;
+	//meshes replaced while each frame was being prepared, their ranges and buffers are given back once that frame's fence says it is done
+	std::array<std::vector<std::unique_ptr<ChunkMesh>>, MAX_FRAMES_IN_FLIGHT> retiredMeshes;
+	BlockMesher mesher;
+	//one core is left for the render thread
+	ParallelMesher parallelMesher{ &mesher, (int)std::thread::hardware_concurrency() - 1 };
+	//how chunks near the camera are meshed, instanced once the instanced pipeline is up
+	ParallelMesher::meshStyle blockStyle = ParallelMesher::copiedMesh;
+	bool boxesDrawn = false;
+	//the detail each chunk was last meshed at and the chunk the camera was in when the details were last checked
+	std::unordered_map<uint64_t, detailLevel> chunkDetails;
+	glm::ivec3 detailCameraChunk = glm::ivec3(INT_MAX);
+	//reused every frame
+	std::vector<uint64_t> dirtyChunks;
+	std::vector<MeshedChunk> meshedChunks;
 
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+	void initWindow() {
+		
+		glfwInit();
 
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);//may need to remove this
 
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)swapChainExtent.width;
-		viewport.height = (float)swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
+		glfwSetKeyCallback(window, key_callback);
+		glfwSetMouseButtonCallback(window, mouse_button_callback);
+		glfwSetWindowFocusCallback(window, window_focus_callback);
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
 
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
+		glfwSetWindowUserPointer(window, this);
+		glfwSetWindowSizeCallback(window, WorkSpace::onWindowResized);
+	}
 
-		VkPipelineViewportStateCreateInfo viewportState = {};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
+	static void onWindowResized(GLFWwindow* window, int width, int height) {
+		if (width == 0 || height == 0) return;
 
-		VkPipelineRasterizationStateCreateInfo rasterizer = {};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;
-		//multisampling
-		VkPipelineMultisampleStateCreateInfo multisampling = {};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		multisampling.minSampleShading = 1.0f; // Optional
-		multisampling.pSampleMask = nullptr; // Optional
-		multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-		multisampling.alphaToOneEnable = VK_FALSE; // Optional
-		//depth stencil
-		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
-		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencil.depthTestEnable = VK_TRUE;
-		depthStencil.depthWriteEnable = VK_TRUE;
-		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-		depthStencil.depthBoundsTestEnable = VK_FALSE;
-		depthStencil.stencilTestEnable = VK_FALSE;
+		WorkSpace* app = reinterpret_cast<WorkSpace*>(glfwGetWindowUserPointer(window));
+		app->recreateSwapChain();
+	}
+	int x = 0;
+	int y = 0;
 
-		//color blending
-		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+	std::vector<Vertex> verticesInverterModel;
+	std::vector<uint32_t> indicesInverterModel;
 
-		VkPipelineColorBlendStateCreateInfo colorBlending = {};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f; // Optional
-		colorBlending.blendConstants[1] = 0.0f; // Optional
-		colorBlending.blendConstants[2] = 0.0f; // Optional
-		colorBlending.blendConstants[3] = 0.0f; // Optional
+	std::vector<Vertex> verticesModelRotated;
 
-		VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout };
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pSetLayouts = setLayouts;
+	//initialises vulkan
+	void initVulkan() {
+		parallelMesher.packed = packedRendering;
 
-		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr,
-			pipelineLayout.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
+		createInstance();
+		setupDebugCallback();
+		createSurface();
+		pickPhysicalDevice();
+		createLogicalDevice();
+		memoryAllocator.init(physicalDevice, device);
+		createSwapChain();
+		createImageViews();
+		createRenderPass();
+		createDescriptorSetLayout();
+		createGraphicsPipeline();
+		createCommandPool();
+		createStagingRing();
+		createDepthResources();
+		createFramebuffers();
+		createTextureImage();
+		createTextureImageView();
+		createTextureSampler();
+		
+		mesher.loadModel(&verticesInverterModel, &indicesInverterModel, "models/xyzOrigin.obj", glm::vec3(0.1, 0.9, 0.1));
+		mesher.loadPrimitives();
+		if (instancedRendering) {
+			std::vector<Vertex> primitiveVertices;
+			std::vector<uint32_t> primitiveIndices;
+			mesher.getPrimitiveGeometry(&primitiveVertices, &primitiveIndices, &primitiveRanges);
+			std::vector<uint16_t> primitiveShortIndices(primitiveIndices.begin(), primitiveIndices.end());
+			createVertexBuffer(primitiveVertices, primitiveVertexBuffer, primitiveVertexBufferMemory);
+			createIndexBuffer(primitiveShortIndices, primitiveIndexBuffer, primitiveIndexBufferMemory);
+			blockStyle = ParallelMesher::instancedMesh;
 		}
 
-		VkGraphicsPipelineCreateInfo pipelineInfo = {};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = &depthStencil;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.renderPass = renderPass;
-		pipelineInfo.subpass = 0;
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-		pipelineInfo.basePipelineIndex = -1; // Optional
-
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create graphics pipeline!");
-		}
+		Vertex temp = {};
+		temp.texCoord = { 0, 0 };
+		temp.pos = { 1, 1, 1 };
+		temp.color = { 1, 0, 1 };
+		vertices.push_back(temp);
+		temp.texCoord = { 0, 0 };
+		temp.pos = { 5, 1, 1 };
+		temp.color = { 1, 0, 0 };
+		vertices.push_back(temp);
+		temp.texCoord = { 0, 0 };
+		temp.pos = { 1, 5, 1 };
+		temp.color = { 1, 1, 1 };
+		vertices.push_back(temp);
+		indices.push_back(vertices.size() - 3);
+		indices.push_back(vertices.size() - 2);
+		indices.push_back(vertices.size() - 1);
+		//for (int i = 0; i < 500; i++) {
+			//addVectors(&vertices, &indices, &verticesInverterModel, &indicesInverterModel);
+		//}
 
+		createVertexBuffer(vertices, vertexBuffer, vertexBufferMemory);
+		createIndexBuffer(indices, indexBuffer, indexBufferMemory);
+		createUniformBuffer();
+		createDescriptorPool();
+		createDescriptorSet();
+		createCommandBuffers();
+		createSemaphores();
+		//the first frame may replace the buffers made here, so their copies have to be done by then
+		stagingRing.waitIdle();
 	}
-	//wrapping the shader code in a VkShaderModule object
-	void createShaderModule(const std::vector<char>& code, VDeleter<VkShaderModule>& shaderModule) {
-		VkShaderModuleCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = (uint32_t*)code.data();
-
-		if (vkCreateShaderModule(device, &createInfo, nullptr, shaderModule.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create shader module!");
+	bool drawBoxes = false;
+	//queues every chunk for meshing again, the old meshes stay on screen until the new ones arrive
+	void drawBlocks() {
+		dirtyChunks.clear();
+		blocks.takeDirtyChunks(&dirtyChunks);
+		for (auto& chunkEntry : blocks.chunks) {
+			dirtyChunks.push_back(chunkEntry.first);
 		}
-
-	}
-	void deleteBlock() {
-		glm::vec3 temp = getSelectedBlock();
-		blocks.removeBlock(temp.x, temp.y, temp.z);
-		verticesChanged = true;
+		std::sort(dirtyChunks.begin(), dirtyChunks.end());
+		dirtyChunks.erase(std::unique(dirtyChunks.begin(), dirtyChunks.end()), dirtyChunks.end());
+		requestMeshes(dirtyChunks);
 	}
-	glm::vec3 getSelectedBlock() {
-		glm::vec3 temp = cameraPosition;
-		float radius = 150;
-		for (int i = 0; i < radius; i++) {
-			cameraPosition += glm::vec3(direction.x / 25, direction.y / 25, direction.z / 25);
-			if (blocks.getBlock(cameraPosition.x, cameraPosition.y, cameraPosition.z)) {
-				return glm::vec3(floor(cameraPosition.x), floor(cameraPosition.y), floor(cameraPosition.z));
+	detailLevel getChunkDetail(const Chunk& chunk) {
+		if (boxesDrawn) {
+			return boxDetail;
+		}
+		float projectionScale = swapChainExtent.height / (2 * tan(glm::radians(FOV) / 2));
+		return chooseChunkDetail(chunk, cameraPosition, projectionScale);
+	}
+	//sends chunks to the mesher threads at the detail each one needs from where the camera is
+	void requestMeshes(const std::vector<uint64_t>& keys) {
+		std::vector<uint64_t> detailKeys[3];
+		for (size_t i = 0; i < keys.size(); i++) {
+			auto it = blocks.chunks.find(keys[i]);
+			//a removed chunk still needs a request so its old mesh is dropped
+			if (it == blocks.chunks.end()) {
+				chunkDetails.erase(keys[i]);
+				detailKeys[fullDetail].push_back(keys[i]);
+				continue;
 			}
+			detailLevel detail = getChunkDetail(*it->second);
+			chunkDetails[keys[i]] = detail;
+			detailKeys[detail].push_back(keys[i]);
+		}
+		std::shared_ptr<const BlockSnapshot> snapshot = blocks.getSnapshot();
+		if (!detailKeys[fullDetail].empty()) {
+			parallelMesher.meshChunks(snapshot, detailKeys[fullDetail], blockStyle);
+		}
+		if (!detailKeys[reducedDetail].empty()) {
+			parallelMesher.meshChunks(snapshot, detailKeys[reducedDetail], blockStyle, true);
+		}
+		if (!detailKeys[boxDetail].empty()) {
+			parallelMesher.meshChunks(snapshot, detailKeys[boxDetail], ParallelMesher::boxMesh);
 		}
-		return glm::vec3(NULL, NULL, NULL);
 	}
-	glm::vec3 getLineFaceIntersect(glm::vec3 min, glm::vec3 max, glm::vec3 origin, glm::vec3 direction, int orientation) {
-		//orientation 1: XZ, 2: ZY, 3: XY
-		direction *= 100;
-		direction += origin;
-		glm::vec3 intersection;
-		switch (orientation) {
-		case 1:
-			intersection.y = min.y;
-			intersection.x = origin.x + abs(direction.x - origin.x)*((min.y - origin.y) / (direction.y - origin.y));
-			intersection.z = origin.z + abs(direction.z - origin.z)*((min.y - origin.y) / (direction.y - origin.y));
-
-			if (intersection.x <= max.x && intersection.x >= min.x && intersection.z <= max.z && intersection.z >= min.z) {
-				return intersection;
-			}
-			break;
-		case 2:
-			intersection.x = min.x;
-			intersection.y = origin.y + abs(direction.y - origin.y)*((min.x - origin.x) / (direction.x - origin.x));
-			intersection.z = origin.z + abs(direction.z - origin.z)*((min.x - origin.x) / (direction.x - origin.x));
-
-			if (intersection.y <= max.y && intersection.y >= min.y && intersection.z <= max.z && intersection.z >= min.z) {
-				return intersection;
+	//sends the chunks edits have touched since the last frame to the mesher threads and uploads whatever they have finished
+	//the render thread never meshes, so a big remesh spreads over a few frames instead of stalling one, returns how many meshes changed
+	int updateChunkMeshes() {
+		dirtyChunks.clear();
+		blocks.takeDirtyChunks(&dirtyChunks);
+		//once the camera crosses into another chunk the chunks around it may need more or less detail
+		glm::ivec3 cameraChunk = glm::ivec3(glm::floor(cameraPosition / (float)CHUNK_SIZE));
+		if (cameraChunk != detailCameraChunk) {
+			detailCameraChunk = cameraChunk;
+			for (auto& detailEntry : chunkDetails) {
+				auto it = blocks.chunks.find(detailEntry.first);
+				if (it != blocks.chunks.end() && getChunkDetail(*it->second) != detailEntry.second) {
+					dirtyChunks.push_back(detailEntry.first);
+				}
 			}
-			break;
-		case 3:
-			intersection.z = min.z;
-			intersection.x = origin.x + abs(direction.x - origin.x)*((min.z - origin.z) / (direction.z - origin.z));
-			intersection.y = origin.y + abs(direction.y - origin.y)*((min.z - origin.z) / (direction.z - origin.z));
-
-			if (intersection.x <= max.x && intersection.x >= min.x && intersection.y <= max.y && intersection.y >= min.y) {
-				return intersection;
+			std::sort(dirtyChunks.begin(), dirtyChunks.end());
+			dirtyChunks.erase(std::unique(dirtyChunks.begin(), dirtyChunks.end()), dirtyChunks.end());
+		}
+		if (!dirtyChunks.empty()) {
+			requestMeshes(dirtyChunks);
+		}
+		parallelMesher.takeCompleted(&meshedChunks);
+		//a chunk meshed twice since the last frame only needs its newest mesh
+		std::unordered_set<uint64_t> newestKeys;
+		for (size_t i = meshedChunks.size(); i-- > 0;) {
+			if (!newestKeys.insert(meshedChunks[i].key).second) {
+				meshedChunks.erase(meshedChunks.begin() + i);
 			}
-			break;
 		}
-		return glm::vec3(NULL, NULL, NULL);
-	}
-	float get3DDistance(glm::vec3 p1, glm::vec3 p2) {
-		if (p1 == glm::vec3(NULL, NULL, NULL) || p2 == glm::vec3(NULL, NULL, NULL)) {
-			return NULL;
-		}
-		return sqrt(pow((p1.x - p2.x), 2) + pow((p1.y - p2.y), 2) + pow((p1.z - p2.z), 2));
-	}
-	int getSide(glm::vec3 block) {
-		std::vector<glm::vec3> intersections;
-		//top XZ
-		glm::vec3 min = glm::vec3(block.x, block.y + 1, block.z);
-		glm::vec3 max = glm::vec3(block.x + 1, block.y + 1, block.z + 1);
-		intersections.push_back(getLineFaceIntersect(min, max, cameraPosition, direction, 1));
-		//bottom XZ
-		min = glm::vec3(block.x, block.y, block.z);
-		max = glm::vec3(block.x + 1, block.y, block.z + 1);
-		intersections.push_back(getLineFaceIntersect(min, max, cameraPosition, direction, 1));
-		//back ZY
-		min = glm::vec3(block.x + 1, block.y, block.z);
-		max = glm::vec3(block.x + 1, block.y + 1, block.z + 1);
-		intersections.push_back(getLineFaceIntersect(min, max, cameraPosition, direction, 2));
-		//front ZY
-		min = glm::vec3(block.x, block.y, block.z);
-		max = glm::vec3(block.x, block.y + 1, block.z + 1);
-		intersections.push_back(getLineFaceIntersect(min, max, cameraPosition, direction, 2));
-		//back XY
-		min = glm::vec3(block.x, block.y, block.z + 1);
-		max = glm::vec3(block.x + 1, block.y + 1, block.z + 1);
-		intersections.push_back(getLineFaceIntersect(min, max, cameraPosition, direction, 3));
-		//front XY
-		min = glm::vec3(block.x, block.y, block.z);
-		max = glm::vec3(block.x + 1, block.y + 1, block.z);
-		intersections.push_back(getLineFaceIntersect(min, max, cameraPosition, direction, 3));
-
-		int smallestDistanceIndex = 0;
-		float smallestDistance = 1000000000;
-		for (int i = 0; i < intersections.size(); i++) {
-			float temp = get3DDistance(cameraPosition, intersections[i]);
-			if (temp < smallestDistance && temp != NULL) {
-				smallestDistance = temp;
-				smallestDistanceIndex = i;
-			}
-		}
-		if (smallestDistance == 1000000000) {
-			return NULL;
-		}
-		return smallestDistanceIndex;
-		//top XZ: 0
-		//bottom XZ: 1
-		//back ZY: 2
-		//front ZY: 3
-		//back XY: 4
-		//front XY: 5
+		for (size_t i = 0; i < meshedChunks.size(); i++) {
+			uploadChunkMesh(meshedChunks[i]);
+		}
+		return (int)meshedChunks.size();
 	}
-	void placeBlock() {
-		glm::vec3 block = getSelectedBlock();
-		int face = getSide(block);
-		//FACES:
-		//top XZ: 0
-		//bottom XZ: 1
-		//back ZY: 2
-		//front ZY: 3
-		//back XY: 4
-		//front XY: 5
-		std::cout << face << std::endl;
- 		switch (face) {
-		case 0:
-			blocks.addBlock(block.x, block.y+1, block.z, blockSelected, positiveY);
-			break;
-		case 1:
-			blocks.addBlock(block.x, block.y-1, block.z, blockSelected, negativeY);
-			break;
-		case 2:
-			blocks.addBlock(block.x+1, block.y, block.z, blockSelected, positiveX);
-			break;
-		case 3:
-			blocks.addBlock(block.x-1, block.y, block.z, blockSelected, negativeX);
-			break;
-		case 4:
-			blocks.addBlock(block.x, block.y, block.z+1, blockSelected, positiveZ);
-			break;
-		case 5:
-			blocks.addBlock(block.x, block.y, block.z-1, blockSelected, negativeZ);
-			break;
+	//replaces one chunk's geometry, the mesh is dropped if the chunk is gone or has nothing to draw
+	void uploadChunkMesh(const MeshedChunk& meshed) {
+		releaseChunkMesh(meshed.key);
+		uint32_t indexCount = (uint32_t)(meshed.indices.size() + meshed.shortIndices.size());
+		if (indexCount == 0 && meshed.instances.empty()) {
+			return;
+		}
+		ChunkMesh& mesh = *(chunkMeshes[meshed.key] = std::unique_ptr<ChunkMesh>(new ChunkMesh(device, memoryAllocator)));
+		if (!meshed.instances.empty()) {
+			createVertexBuffer(meshed.instances, mesh.instanceBuffer, mesh.instanceBufferMemory);
+			mesh.instanceCounts = meshed.instanceCounts;
+			return;
+		}
+		bool packed = !meshed.packedVertices.empty();
+		VkIndexType indexType = meshed.shortIndices.empty() ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+		mesh.vertexCount = (uint32_t)(packed ? meshed.packedVertices.size() : meshed.vertices.size());
+		mesh.indexCount = indexCount;
+		mesh.page = allocateChunkRanges(packed, indexType, mesh.vertexCount, mesh.indexCount, &mesh.vertexOffset, &mesh.firstIndex);
+		mesh.sections = meshed.sections;
+		mesh.origin = meshed.origin;
+		ChunkPage& page = *chunkPages[mesh.page];
+		if (packed) {
+			copyToBuffer(meshed.packedVertices, page.vertexBuffer, mesh.vertexOffset);
+		}
+		else {
+			copyToBuffer(meshed.vertices, page.vertexBuffer, mesh.vertexOffset);
+		}
+		if (indexType == VK_INDEX_TYPE_UINT16) {
+			copyToBuffer(meshed.shortIndices, page.indexBuffer, mesh.firstIndex);
+		}
+		else {
+			copyToBuffer(meshed.indices, page.indexBuffer, mesh.firstIndex);
 		}
-		verticesChanged = true;
 	}
-	float velocity = 0.01;
-	double xpos, ypos;
-	glm::vec3 cameraMin = glm::vec3(-0.15, -0.25, -0.15);
-	glm::vec3 cameraMax = glm::vec3(0.15, 0.7, 0.15);
-	glm::vec3 cameraOffset = glm::vec3(0.15, 0.85, 0.15);
-	glm::vec3 cameraVel = glm::vec3(0, 0, 0);
-	float gVel = 0;
-	bool t = false;
-	float time = 0;
-	bool mouseLeftLatch;
-	bool mouseRightLatch;
-	blockType blockSelected = wire;
-	void mainLoop() {
-		while (!glfwWindowShouldClose(window)) {
-			
-			//checks for window events (x button, etc)	
-			glfwPollEvents();
-			
-			updateUniformBuffer();
-			
-			if (keys.n1) {
-				blockSelected = wire;
-			}
-			else if (keys.n2) {
-				blockSelected = inverter;
-			}
-			else if (keys.n3) {
-				blockSelected = andGate;
-			}
-			else if (keys.n4) {
-				blockSelected = orGate;
-			}
-			else if (keys.n5) {
-				blockSelected = xorGate;
+	//takes a chunk's mesh out of the drawn set, the frames in flight may still read it so it is only retired here
+	void releaseChunkMesh(uint64_t key) {
+		auto it = chunkMeshes.find(key);
+		if (it == chunkMeshes.end()) {
+			return;
+		}
+		retiredMeshes[currentFrame].push_back(std::move(it->second));
+		chunkMeshes.erase(it);
+	}
+	//gives back what was retired while a frame was prepared, its page ranges, instance buffers and command buffers
+	//only called once that frame's fence is signalled, which also covers every frame submitted before it
+	void freeRetired(size_t frame) {
+		for (size_t i = 0; i < retiredMeshes[frame].size(); i++) {
+			const ChunkMesh& mesh = *retiredMeshes[frame][i];
+			if (mesh.page >= 0) {
+				chunkPages[mesh.page]->vertexRanges.free(mesh.vertexOffset, mesh.vertexCount);
+				chunkPages[mesh.page]->indexRanges.free(mesh.firstIndex, mesh.indexCount);
 			}
-			
-			
-			
-			
-			if (cameraVel.y != gVel) {
-				if (t == true) {
-					gVel = 0;
-				}
+		}
+		retiredMeshes[frame].clear();
+		if (!retiredCommandBuffers[frame].empty()) {
+			vkFreeCommandBuffers(device, commandPool, retiredCommandBuffers[frame].size(), retiredCommandBuffers[frame].data());
+			retiredCommandBuffers[frame].clear();
+		}
+	}
+	//blocks until every submitted frame has been drawn, for replacing something they all read
+	void waitForFrames() {
+		std::vector<VkFence> fences;
+		for (size_t i = 0; i < frameFences.size(); i++) {
+			fences.push_back(frameFences[i]);
+		}
+		vkWaitForFences(device, fences.size(), fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+	//finds room for a mesh in a page of the right kind, making a new page when none has space, returns the page's index
+	int allocateChunkRanges(bool packed, VkIndexType indexType, uint32_t vertexCount, uint32_t indexCount, uint32_t* vertexOffset, uint32_t* firstIndex) {
+		for (size_t i = 0; i < chunkPages.size(); i++) {
+			ChunkPage& page = *chunkPages[i];
+			if (page.packed != packed || page.indexType != indexType || !page.vertexRanges.allocate(vertexCount, vertexOffset)) {
+				continue;
 			}
-			gVel -= 0.006;
-			for (int i = 0; i < 1; i++) {
-				//blocks.addBlock(((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120);
+			if (page.indexRanges.allocate(indexCount, firstIndex)) {
+				return (int)i;
 			}
+			page.vertexRanges.free(*vertexOffset, vertexCount);
+		}
+		//a mesh bigger than a whole page gets a page of its own size
+		uint32_t vertexCapacity = std::max(vertexCount, CHUNK_PAGE_VERTICES);
+		uint32_t indexCapacity = std::max(indexCount, CHUNK_PAGE_INDICES);
+		std::unique_ptr<ChunkPage> page(new ChunkPage(device, memoryAllocator, vertexCapacity, indexCapacity));
+		page->packed = packed;
+		page->indexType = indexType;
+		VkDeviceSize vertexSize = packed ? sizeof(PackedVertex) : sizeof(Vertex);
+		VkDeviceSize indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		createBuffer(vertexCapacity * vertexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, page->vertexBuffer, page->vertexBufferMemory);
+		createBuffer(indexCapacity * indexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, page->indexBuffer, page->indexBufferMemory);
+		page->vertexRanges.allocate(vertexCount, vertexOffset);
+		page->indexRanges.allocate(indexCount, firstIndex);
+		chunkPages.push_back(std::move(page));
+		return (int)chunkPages.size() - 1;
+	}
 
-			if (keys.ctrl) {
-				velocity = 0.1;
-			}
-			else {
-				velocity = 0.02;
-			}
-			t = false;
-			if (keys.space) {
-				cameraVel.y = velocity;
-				gVel = 0;
-			}
-			else if (keys.shift) {
-				cameraVel.y = -velocity;
-				gVel = 0;
-			}
-			else {
-				t = true;
-				cameraVel.y = gVel;
-				cameraVel.y = 0;
-			}
-			glm::vec3 forward = glm::vec3(sin(cameraAngle.x), 0, cos(cameraAngle.x));
-			cameraVel.x *= 0.35;
-			cameraVel.z *= 0.35;
-			if (keys.w && !keys.s) {
-				cameraVel += glm::vec3(forward.x, 0, forward.z) * velocity;
-			}
-			else if (keys.s) {
-				cameraVel += glm::vec3(forward.x, 0, forward.z) * -velocity;
-			}
-			
-			if (keys.a && !keys.d) {
-				cameraVel += -right * velocity;
-			}
-			else if (keys.d) {
-				cameraVel += right * velocity;;
-			}
+	void addFace(int p1, int p2, int p3, int p4) {
+		indices.push_back(p1);
+		indices.push_back(p2);
+		indices.push_back(p3);
+		indices.push_back(p1);
+		indices.push_back(p3);
+		indices.push_back(p4);
+	}
 
-			if (keys.tab) {
-				drawBoxes = true;
-				//FOV = 20;
-			}
-			else {
-				drawBoxes = false;
-				//FOV = 75;
-			}
 
-			if (keys.mouseLeft) {
-				if (mouseLeftLatch) {
-					deleteBlock();
-				}
-				mouseLeftLatch = false;
-			}
-			else {
-				mouseLeftLatch = true;
+
+	void addVectors(std::vector<Vertex>* originalVertices, std::vector<uint32_t>* originalIndices, std::vector<Vertex>* vertices, std::vector<uint32_t>* indices) {
+		int temp = originalVertices->size();
+		for (int i = 0; i < vertices->size(); i++) {
+			originalVertices->push_back(vertices->at(i));
+		}
+		for (int i = 0; i < indices->size(); i++) {
+			originalIndices->push_back(indices->at(i) + temp);
+		}
+	}
+	void createDepthResources() {
+		VkFormat depthFormat = findDepthFormat();
+
+		createImage(swapChainExtent.width, swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+		createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, depthImageView);
+
+		transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	}
+
+	VkFormat findDepthFormat() {
+		return findSupportedFormat(
+		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		);
+	}
+
+	VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
+		for (VkFormat format : candidates) {
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+
+			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
+				return format;
 			}
-			if (keys.mouseRight) {
-				if (mouseRightLatch) {
-					placeBlock();
-				}
-				mouseRightLatch = false;
+			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
+				return format;
 			}
-			else {
-				mouseRightLatch = true;
+		}
+
+		throw std::runtime_error("failed to find supported format!");
+	}
+
+	void createTextureSampler() {
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		samplerInfo.maxAnisotropy = 16;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = 0.0f;
+		if (vkCreateSampler(device, &samplerInfo, nullptr, textureSampler.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture sampler!");
+		}
+	}
+
+	void createTextureImageView() {
+		createImageView(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, textureImageView);
+	}
+
+	void createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VDeleter<VkImageView>& imageView) {
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspectFlags;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device, &viewInfo, nullptr, imageView.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture image view!");
+		}
+	}
+
+	void createTextureImage() {
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		if (!pixels) {
+			throw std::runtime_error("failed to load texture image!");
+		}
+
+		createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
+
+		//the pixels go straight from the staging ring into the optimal image, the layout changes on either side of the copy are part of the same batch
+		stagingRing.uploadImage(pixels, texWidth, texHeight, 4, textureImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		stbi_image_free(pixels);
+	}
+
+	//creating the image object
+	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VDeleter<VkImage>& image, DeviceMemory& imageMemory) {
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = width;
+		imageInfo.extent.height = height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = tiling;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+		imageInfo.usage = usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateImage(device, &imageInfo, nullptr, image.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create image!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+		imageMemory.assign(memoryAllocator.allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_OPTIMAL));
+
+		vkBindImageMemory(device, image, imageMemory.getMemory(), imageMemory.getOffset());
+	}
+
+	bool hasStencilComponent(VkFormat format) {
+		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+	}
+
+	//queues the layout change on the staging ring, it is recorded with the ring's next batch instead of in a submission of its own
+	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+
+		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+			if (hasStencilComponent(format)) {
+				barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
 			}
+		}
+		else {
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		//images filled through the ring get their layouts from uploadImage, so only layouts nothing is copied into are left here
+		VkPipelineStageFlags srcStages;
+		VkPipelineStageFlags dstStages;
+		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			dstStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		}
+		else {
+			throw std::invalid_argument("unsupported layout transition!");
+		}
+
+		stagingRing.transitionImage(barrier, srcStages, dstStages);
+	}
+
+
+	void createDescriptorSet() {
+		VkDescriptorSetLayout layouts[] = { descriptorSetLayout };
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = layouts;
+
+		if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate descriptor set!");
+		}
+
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = uniformBuffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = sizeof(UniformBufferObject);
+
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = textureImageView;
+		imageInfo.sampler = textureSampler;
+
+		std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = descriptorSet;
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = descriptorSet;
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(device, descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+	}
+
+	void createDescriptorPool() {
+		std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		poolSizes[0].descriptorCount = 1;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[1].descriptorCount = 1;
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = poolSizes.size();
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = 1;
+
+		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, descriptorPool.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+	}
+
+	//one slot per swap chain image, a frame only writes the slot of the image it draws to, so it never touches what another frame is reading
+	void createUniformBuffer() {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		VkDeviceSize alignment = std::max<VkDeviceSize>(1, properties.limits.minUniformBufferOffsetAlignment);
+		uniformSlotSize = (sizeof(UniformBufferObject) + alignment - 1) / alignment * alignment;
+
+		createBuffer(uniformSlotSize * swapChainImages.size(), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffer, uniformBufferMemory);
+		//new slots have no frame reading them
+		imageFences.assign(swapChainImages.size(), VK_NULL_HANDLE);
+	}
+
+	void createDescriptorSetLayout() {
+		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
+		uboLayoutBinding.binding = 0;
+		uboLayoutBinding.descriptorCount = 1;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		uboLayoutBinding.pImmutableSamplers = nullptr;
+		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
+		samplerLayoutBinding.binding = 1;
+		samplerLayoutBinding.descriptorCount = 1;
+		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		samplerLayoutBinding.pImmutableSamplers = nullptr;
+		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = bindings.size();
+		layoutInfo.pBindings = bindings.data();
+
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, descriptorSetLayout.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
+	}
+
+	//creating the index buffer, uint32_t or uint16_t indices
+	template<typename T>
+	void createIndexBuffer(const std::vector<T>& _indices, VDeleter<VkBuffer>& _indexBuffer, DeviceMemory& _indexBufferMemory) {
+		VkDeviceSize bufferSize = sizeof(_indices[0]) * _indices.size();
+
+		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexBuffer, _indexBufferMemory);
+
+		stagingRing.uploadBuffer(_indices.data(), bufferSize, _indexBuffer, 0);
+	}
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VDeleter<VkBuffer>& buffer, DeviceMemory& bufferMemory) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, buffer.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create buffer!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+		bufferMemory.assign(memoryAllocator.allocate(memRequirements, properties, false));
+
+		vkBindBufferMemory(device, buffer, bufferMemory.getMemory(), bufferMemory.getOffset());
+	}
+
+	//works for any vertex or instance record, Vertex, PackedVertex or BlockInstance
+	template<typename T>
+	void createVertexBuffer(const std::vector<T>& _vertices, VDeleter<VkBuffer>& _vertexBuffer, DeviceMemory& _vertexBufferMemory) {
+		VkDeviceSize bufferSize = sizeof(_vertices[0]) * _vertices.size();
+
+		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vertexBuffer, _vertexBufferMemory);
+
+		stagingRing.uploadBuffer(_vertices.data(), bufferSize, _vertexBuffer, 0);
+	}
+	//writes records into an existing buffer starting at record firstElement, used to fill a range of a shared page
+	template<typename T>
+	void copyToBuffer(const std::vector<T>& _data, VkBuffer _buffer, uint32_t firstElement) {
+		VkDeviceSize bufferSize = sizeof(_data[0]) * _data.size();
+
+		stagingRing.uploadBuffer(_data.data(), bufferSize, _buffer, sizeof(_data[0]) * firstElement);
+	}
+	//one ring for every upload, big enough that a full remesh rarely has to wait for it to drain
+	void createStagingRing() {
+		VkDeviceSize ringSize = 32 * 1024 * 1024;
+		createBuffer(ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingRingBuffer, stagingRingMemory);
+		stagingRing.init(device, graphicsQueue, commandPool, stagingRingBuffer, stagingRingMemory.getMapped(), ringSize);
+		if (transferQueue != VK_NULL_HANDLE) {
+			QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+			stagingRing.useTransferQueue(transferQueue, transferCommandPool, queueFamilyIndices.transferFamily, queueFamilyIndices.graphicsFamily);
+		}
+	}
+
+	//re-creating the swap chain for when it becomes incompatible, like when the window is resized
+	void recreateSwapChain() {
+		vkDeviceWaitIdle(device);
+
+		createSwapChain();
+		createImageViews();
+		createRenderPass();
+		createGraphicsPipeline();
+		createDepthResources();
+		createFramebuffers();
+		//the image count can change with the swap chain, and the uniform slots go with it
+		createUniformBuffer();
+		createDescriptorPool();
+		createDescriptorSet();
+		createCommandBuffers();
+	}
+
+	void createSemaphores() {
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		//made signalled, there is no frame to wait for before the first ones
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT, VDeleter<VkSemaphore>{ device, vkDestroySemaphore });
+		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT, VDeleter<VkSemaphore>{ device, vkDestroySemaphore });
+		frameFences.resize(MAX_FRAMES_IN_FLIGHT, VDeleter<VkFence>{ device, vkDestroyFence });
+		for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, imageAvailableSemaphores[i].replace()) != VK_SUCCESS ||
+				vkCreateSemaphore(device, &semaphoreInfo, nullptr, renderFinishedSemaphores[i].replace()) != VK_SUCCESS) {
+
+				throw std::runtime_error("failed to create semaphores!");
+			}
+			if (vkCreateFence(device, &fenceInfo, nullptr, frameFences[i].replace()) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create fence!");
+			}
+		}
+	}
+	//allocates and records commands for every swapchain image
+	void createCommandBuffers() {
+		//the frames in flight may still be running the old command buffers, so they are freed once the frame being prepared is done
+		std::vector<VkCommandBuffer>& retired = retiredCommandBuffers[currentFrame];
+		retired.insert(retired.end(), commandBuffers.begin(), commandBuffers.end());
+
+		commandBuffers.resize(swapChainFramebuffers.size());
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+
+		if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
+
+		//chunk meshes sorted by page so each page is bound once
+		std::vector<const ChunkMesh*> pageMeshes;
+		for (auto& meshEntry : chunkMeshes) {
+			if (meshEntry.second->page >= 0) {
+				pageMeshes.push_back(meshEntry.second.get());
+			}
+		}
+		std::sort(pageMeshes.begin(), pageMeshes.end(), [](const ChunkMesh* a, const ChunkMesh* b) { return a->page < b->page; });
+
+		for (size_t i = 0; i < commandBuffers.size(); i++) {
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+			vkBeginCommandBuffer(commandBuffers[i], &beginInfo);
+
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = renderPass;
+			renderPassInfo.framebuffer = swapChainFramebuffers[i];
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = swapChainExtent;
+
+			std::array<VkClearValue, 2> clearValues = {};
+			clearValues[0].color = { 0.9f, 0.9f, 0.9f, 1.0f };
+			clearValues[1].depthStencil = { 1.0f, 0 };
+
+			renderPassInfo.clearValueCount = clearValues.size();
+			renderPassInfo.pClearValues = clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+
+			uint32_t uniformOffset = (uint32_t)(uniformSlotSize * i);
+			vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &uniformOffset);
+
+			VkDeviceSize offsets[] = { 0 };
+			if (!indices.empty()) {
+				VkBuffer vertexBuffers[] = { vertexBuffer };
+				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+				vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				vkCmdDrawIndexed(commandBuffers[i], indices.size(), 1, 0, 0, 0);
+			}
+			//chunk meshes go page by page, a page's buffers are bound once and each section of a mesh is one draw into them
+			//packed meshes are placed by their chunk's origin
+			for (size_t m = 0; m < pageMeshes.size(); m++) {
+				const ChunkMesh& mesh = *pageMeshes[m];
+				const ChunkPage& page = *chunkPages[mesh.page];
+				if (m == 0 || mesh.page != pageMeshes[m - 1]->page) {
+					vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, page.packed ? packedPipeline : graphicsPipeline);
+					VkBuffer vertexBuffers[] = { page.vertexBuffer };
+					vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+					vkCmdBindIndexBuffer(commandBuffers[i], page.indexBuffer, 0, page.indexType);
+				}
+				if (page.packed) {
+					glm::ivec4 origin(mesh.origin, 0);
+					vkCmdPushConstants(commandBuffers[i], pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(origin), &origin);
+				}
+				for (size_t s = 0; s < mesh.sections.size(); s++) {
+					const IndexSection& section = mesh.sections[s];
+					vkCmdDrawIndexed(commandBuffers[i], section.indexCount, 1, mesh.firstIndex + section.firstIndex, (int32_t)(mesh.vertexOffset + section.vertexBase), 0);
+				}
+			}
+			//instanced chunks share the primitive buffers and draw each primitive once, firstInstance picks its group in the chunk's instance buffer
+			if (instancedRendering) {
+				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipeline);
+				VkBuffer primitiveBuffers[] = { primitiveVertexBuffer };
+				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, primitiveBuffers, offsets);
+				vkCmdBindIndexBuffer(commandBuffers[i], primitiveIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+				for (auto& meshEntry : chunkMeshes) {
+					const ChunkMesh& mesh = *meshEntry.second;
+					if (mesh.instanceCounts.empty()) {
+						continue;
+					}
+					VkBuffer instanceBuffers[] = { mesh.instanceBuffer };
+					vkCmdBindVertexBuffers(commandBuffers[i], 1, 1, instanceBuffers, offsets);
+					uint32_t firstInstance = 0;
+					for (size_t p = 0; p < primitiveRanges.size(); p++) {
+						uint32_t instanceCount = mesh.instanceCounts[p];
+						if (instanceCount > 0) {
+							vkCmdDrawIndexed(commandBuffers[i], primitiveRanges[p].indexCount, instanceCount, primitiveRanges[p].firstIndex, primitiveRanges[p].vertexOffset, firstInstance);
+						}
+						firstInstance += instanceCount;
+					}
+				}
+			}
+
+			vkCmdEndRenderPass(commandBuffers[i]);
+
+			if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to record command buffer!");
+			}
+		}
+	}
+	//manages the memory that is used to store command buffers
+	void createCommandPool() {
+		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+		poolInfo.flags = 0; // Optional
+
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, commandPool.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create command pool!");
+		}
+		if (transferQueue != VK_NULL_HANDLE) {
+			poolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily;
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, transferCommandPool.replace()) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create transfer command pool!");
+			}
+		}
+	}
+
+	void createFramebuffers() {
+		swapChainFramebuffers.resize(swapChainImageViews.size(), VDeleter<VkFramebuffer>{device, vkDestroyFramebuffer});
+
+		for (size_t i = 0; i < swapChainImageViews.size(); i++) {
+			std::array<VkImageView, 2> attachments = {
+				swapChainImageViews[i],
+				depthImageView
+			};
+
+			VkFramebufferCreateInfo framebufferInfo = {};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.attachmentCount = attachments.size();
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = swapChainExtent.width;
+			framebufferInfo.height = swapChainExtent.height;
+			framebufferInfo.layers = 1;
+
+			if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, swapChainFramebuffers[i].replace()) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create framebuffer!");
+			}
+		}
+	}
+
+	void createRenderPass() {
+		VkAttachmentDescription colorAttachment = {};
+		colorAttachment.format = swapChainImageFormat;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		VkAttachmentDescription depthAttachment = {};
+		depthAttachment.format = findDepthFormat();
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef = {};
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthAttachmentRef = {};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.srcAccessMask = 0;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = attachments.size();
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &dependency;
+
+		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, renderPass.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create render pass!");
+		}
+	}
+
+	void createGraphicsPipeline() {
+		//loading vertex and fragment shaders
+		auto vertShaderCode = readFile("shaders/vert.spv");
+		auto fragShaderCode = readFile("shaders/frag.spv");
+		//only required in the pipeling creation proccess, so defined here instead of as a property of this class
+		VDeleter<VkShaderModule> vertShaderModule{ device, vkDestroyShaderModule };
+		VDeleter<VkShaderModule> fragShaderModule{ device, vkDestroyShaderModule };
+
+		createShaderModule(vertShaderCode, vertShaderModule);
+		createShaderModule(fragShaderCode, fragShaderModule);
+
+		VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
+		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+
+		vertShaderStageInfo.module = vertShaderModule;
+		vertShaderStageInfo.pName = "main";
+
+		VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
+		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		fragShaderStageInfo.module = fragShaderModule;
+		fragShaderStageInfo.pName = "main";
+
+		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+		auto bindingDescription = Vertex::getBindingDescription();
+		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)swapChainExtent.width;
+		viewport.height = (float)swapChainExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = swapChainExtent;
+
+		VkPipelineViewportStateCreateInfo viewportState = {};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.pViewports = &viewport;
+		viewportState.scissorCount = 1;
+		viewportState.pScissors = &scissor;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer = {};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizer.depthBiasEnable = VK_FALSE;
+		//multisampling
+		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		multisampling.minSampleShading = 1.0f; // Optional
+		multisampling.pSampleMask = nullptr; // Optional
+		multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+		multisampling.alphaToOneEnable = VK_FALSE; // Optional
+		//depth stencil
+		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = VK_TRUE;
+		depthStencil.depthWriteEnable = VK_TRUE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.stencilTestEnable = VK_FALSE;
+
+		//color blending
+		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+
+		VkPipelineColorBlendStateCreateInfo colorBlending = {};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+		colorBlending.blendConstants[0] = 0.0f; // Optional
+		colorBlending.blendConstants[1] = 0.0f; // Optional
+		colorBlending.blendConstants[2] = 0.0f; // Optional
+		colorBlending.blendConstants[3] = 0.0f; // Optional
+
+		VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout };
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = setLayouts;
+		//the packed pipeline gets its chunk's origin this way
+		VkPushConstantRange pushConstantRange = {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(glm::ivec4);
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr,
+			pipelineLayout.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = shaderStages;
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.renderPass = renderPass;
+		pipelineInfo.subpass = 0;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1; // Optional
+
+		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create graphics pipeline!");
+		}
+
+		//the instanced pipeline swaps the vertex shader and adds the per instance binding, everything else is shared
+		if (instancedRendering) {
+			auto instancedShaderCode = readFile("shaders/instanced.spv");
+			VDeleter<VkShaderModule> instancedShaderModule{ device, vkDestroyShaderModule };
+			createShaderModule(instancedShaderCode, instancedShaderModule);
+			shaderStages[0].module = instancedShaderModule;
+
+			std::array<VkVertexInputBindingDescription, 2> bindingDescriptions = { bindingDescription, BlockInstance::getBindingDescription() };
+			auto instanceAttributeDescriptions = BlockInstance::getAttributeDescriptions();
+			std::vector<VkVertexInputAttributeDescription> instancedAttributeDescriptions(attributeDescriptions.begin(), attributeDescriptions.end());
+			instancedAttributeDescriptions.insert(instancedAttributeDescriptions.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+			vertexInputInfo.vertexBindingDescriptionCount = bindingDescriptions.size();
+			vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+			vertexInputInfo.vertexAttributeDescriptionCount = instancedAttributeDescriptions.size();
+			vertexInputInfo.pVertexAttributeDescriptions = instancedAttributeDescriptions.data();
+
+			if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, instancedPipeline.replace()) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create instanced pipeline!");
+			}
+		}
+
+		//the packed pipeline swaps the vertex shader and reads PackedVertex instead
+		if (packedRendering) {
+			auto packedShaderCode = readFile("shaders/packed.spv");
+			VDeleter<VkShaderModule> packedShaderModule{ device, vkDestroyShaderModule };
+			createShaderModule(packedShaderCode, packedShaderModule);
+			shaderStages[0].module = packedShaderModule;
+
+			auto packedBindingDescription = PackedVertex::getBindingDescription();
+			auto packedAttributeDescriptions = PackedVertex::getAttributeDescriptions();
+			vertexInputInfo.vertexBindingDescriptionCount = 1;
+			vertexInputInfo.pVertexBindingDescriptions = &packedBindingDescription;
+			vertexInputInfo.vertexAttributeDescriptionCount = packedAttributeDescriptions.size();
+			vertexInputInfo.pVertexAttributeDescriptions = packedAttributeDescriptions.data();
+
+			if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, packedPipeline.replace()) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create packed pipeline!");
+			}
+		}
+
+	}
+	//wrapping the shader code in a VkShaderModule object
+	void createShaderModule(const std::vector<char>& code, VDeleter<VkShaderModule>& shaderModule) {
+		VkShaderModuleCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size();
+		createInfo.pCode = (uint32_t*)code.data();
+
+		if (vkCreateShaderModule(device, &createInfo, nullptr, shaderModule.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shader module!");
+		}
+
+	}
+	void deleteBlock() {
+		glm::ivec3 block;
+		glm::ivec3 normal;
+		if (getSelectedBlock(&block, &normal)) {
+			blocks.removeBlock(block.x, block.y, block.z);
+			verticesChanged = true;
+		}
+	}
+	//the block the camera is looking at within reach, and the normal of the face the view ray hits
+	bool getSelectedBlock(glm::ivec3* block, glm::ivec3* normal) {
+		float reach = 6;
+		return queries.ray(cameraPosition, direction, reach, block, normal);
+	}
+	void placeBlock() {
+		glm::ivec3 block;
+		glm::ivec3 normal;
+		if (!getSelectedBlock(&block, &normal)) {
+			return;
+		}
+		//the new block goes on the face the ray hit and points away from it
+		blockDirection facing;
+		if (normal.y > 0) {
+			facing = positiveY;
+		}
+		else if (normal.y < 0) {
+			facing = negativeY;
+		}
+		else if (normal.x > 0) {
+			facing = positiveX;
+		}
+		else if (normal.x < 0) {
+			facing = negativeX;
+		}
+		else if (normal.z > 0) {
+			facing = positiveZ;
+		}
+		else if (normal.z < 0) {
+			facing = negativeZ;
+		}
+		else {
+			//the camera is inside the block
+			return;
+		}
+		block += normal;
+		blocks.addBlock(block.x, block.y, block.z, blockSelected, facing);
+		verticesChanged = true;
+	}
+	float velocity = 0.01;
+	double xpos, ypos;
+	glm::vec3 cameraMin = glm::vec3(-0.15, -0.25, -0.15);
+	glm::vec3 cameraMax = glm::vec3(0.15, 0.7, 0.15);
+	glm::vec3 cameraOffset = glm::vec3(0.15, 0.85, 0.15);
+	glm::vec3 cameraVel = glm::vec3(0, 0, 0);
+	float gVel = 0;
+	bool t = false;
+	float time = 0;
+	bool mouseLeftLatch;
+	bool mouseRightLatch;
+	blockType blockSelected = wire;
+	void mainLoop() {
+		while (!glfwWindowShouldClose(window)) {
+			
+			//checks for window events (x button, etc)	
+			glfwPollEvents();
+			
+			updateUniformBuffer();
+			
+			if (keys.n1) {
+				blockSelected = wire;
+			}
+			else if (keys.n2) {
+				blockSelected = inverter;
+			}
+			else if (keys.n3) {
+				blockSelected = andGate;
+			}
+			else if (keys.n4) {
+				blockSelected = orGate;
+			}
+			else if (keys.n5) {
+				blockSelected = xorGate;
+			}
+			
+			
+			
+			
+			if (cameraVel.y != gVel) {
+				if (t == true) {
+					gVel = 0;
+				}
+			}
+			gVel -= 0.006;
+			for (int i = 0; i < 1; i++) {
+				//blocks.addBlock(((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120, ((double)rand() / (RAND_MAX)) * 120);
+			}
+
+			if (keys.ctrl) {
+				velocity = 0.1;
+			}
+			else {
+				velocity = 0.02;
+			}
+			t = false;
+			if (keys.space) {
+				cameraVel.y = velocity;
+				gVel = 0;
+			}
+			else if (keys.shift) {
+				cameraVel.y = -velocity;
+				gVel = 0;
+			}
+			else {
+				t = true;
+				cameraVel.y = gVel;
+				cameraVel.y = 0;
+			}
+			glm::vec3 forward = glm::vec3(sin(cameraAngle.x), 0, cos(cameraAngle.x));
+			cameraVel.x *= 0.35;
+			cameraVel.z *= 0.35;
+			if (keys.w && !keys.s) {
+				cameraVel += glm::vec3(forward.x, 0, forward.z) * velocity;
+			}
+			else if (keys.s) {
+				cameraVel += glm::vec3(forward.x, 0, forward.z) * -velocity;
+			}
+			
+			if (keys.a && !keys.d) {
+				cameraVel += -right * velocity;
+			}
+			else if (keys.d) {
+				cameraVel += right * velocity;;
+			}
+
+			if (keys.tab) {
+				drawBoxes = true;
+				//FOV = 20;
+			}
+			else {
+				drawBoxes = false;
+				//FOV = 75;
+			}
+
+			if (keys.mouseLeft) {
+				if (mouseLeftLatch) {
+					deleteBlock();
+				}
+				mouseLeftLatch = false;
+			}
+			else {
+				mouseLeftLatch = true;
+			}
+			if (keys.mouseRight) {
+				if (mouseRightLatch) {
+					placeBlock();
+				}
+				mouseRightLatch = false;
+			}
+			else {
+				mouseRightLatch = true;
+			}
+
+			if (keys.f) {
+				blocks.addBlock(cameraMin.x, cameraMin.y - 1, cameraMin.z, blockSelected);
+			}
+			
+			glm::vec3 test = cameraMin;
+			//blocks.correctCameraWithBlocks(&cameraMin, &cameraMax, &cameraVel);
+			cameraMax += cameraVel;
+			cameraMin += cameraVel;
+			cameraPosition = cameraMin + cameraOffset;
+			if (inFocus) {
+				glfwGetCursorPos(window, &xpos, &ypos);
+				glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
+				cameraAngle.x += 0.003 * float(WIDTH / 2 - xpos);
+				cameraAngle.y += 0.003 * float(HEIGHT / 2 - ypos);
+				if (cameraAngle.y < -3.14 / 2) {
+					cameraAngle.y = -3.14 / 2;
+				}
+				if (cameraAngle.y > 3.14 / 2) {
+					cameraAngle.y = 3.14 / 2;
+				}
+			}
+			drawFrame();
+			//std::cout << "temp: " << temp << ", time: " << time << ", delay: " << delay << ", temp - time: " << temp - time << std::endl;
+			float delay = 1.0f / 60.0f;
+			float temp = glfwGetTime();
+			
+			
+			if (temp - time < delay) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(int(1000 * (delay - (temp - time)))));
+				
+			}
+			else {
+				std::cout << "FRAME DROP" << std::endl;
+				std::cout << "BLOCKS: " << blocks.getVectorSize() << std::endl;
+			}
+			time = glfwGetTime();
+		}
+		//the last frames may still be in flight, and everything they use is destroyed after this
+		vkDeviceWaitIdle(device);
+	}
+
+	glm::vec3 direction;
+
+	glm::vec3 right;
+
+	glm::vec3 up;
+	
+	float FOV = 90;
+
+	void updateUniformBuffer() {
+		static auto startTime = std::chrono::high_resolution_clock::now();
+
+		auto currentTime = std::chrono::high_resolution_clock::now();
+		float time = 0;// std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
+
+		direction = glm::vec3(
+			cos(cameraAngle.y) * sin(cameraAngle.x),
+			sin(cameraAngle.y),
+			cos(cameraAngle.y) * cos(cameraAngle.x)
+		);
+
+		right = glm::vec3(
+			sin(cameraAngle.x - 3.14f / 2.0f),
+			0,
+			cos(cameraAngle.x - 3.14f / 2.0f)
+		);
+
+		up = glm::cross(right, direction);
+
+		UniformBufferObject ubo = {};
+		ubo.model = glm::rotate(glm::mat4(), 0.0f, glm::vec3(0, 0, 1));
+		ubo.view = glm::lookAt(cameraPosition, cameraPosition + direction, up);
+		ubo.proj = glm::perspective(glm::radians(FOV), swapChainExtent.width / (float)swapChainExtent.height, 0.001f, 1000.0f);
+		ubo.proj[1][1] *= -1;
+		ubo.time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
+		frameUniforms = ubo;
+	}
+	void drawRect(float x, float y, float width, float height, float r, float g, float b) {
+		x /= swapChainExtent.width;
+		width /= swapChainExtent.width;
+		y /= swapChainExtent.height;
+		height /= swapChainExtent.height;
+		Vertex temp = {};
+		temp.texCoord = { 0.111, 0 };
+		temp.pos = glm::vec3(x, y, 0);
+		temp.color = { r, g, b };
+		vertices.push_back(temp);
+		temp.pos = glm::vec3(x, y + height, 0);
+		vertices.push_back(temp);
+		temp.pos = glm::vec3(x + width, y + height, 0);
+		vertices.push_back(temp);
+		temp.pos = glm::vec3(x + width, y, 0);
+		vertices.push_back(temp);
+		indices.push_back(vertices.size() - 4);
+		indices.push_back(vertices.size() - 3);
+		indices.push_back(vertices.size() - 2);
+
+		indices.push_back(vertices.size() - 4);
+		indices.push_back(vertices.size() - 2);
+		indices.push_back(vertices.size() - 1);
+	}
+	bool verticesChanged = false;
+	//gets the image from the swap chain, executes the command buffer, with the swapchain image in the framebuffer, returns the image to the swap chain for presentation
+	void drawFrame() {
+		//this frame's resources were last used MAX_FRAMES_IN_FLIGHT frames ago, what was retired then can go once that frame is drawn
+		vkWaitForFences(device, 1, &frameFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		freeRetired(currentFrame);
+
+		//6 rebuilds every chunk, otherwise only the chunks edits touched get new meshes
+		if (keys.n6) {
+			vertices.clear();
+			indices.clear();
+			drawBlocks();
+			verticesChanged = true;
+		}
+		//tab swaps to the box overview and back, every chunk is meshed again in the new style
+		if (drawBoxes != boxesDrawn) {
+			boxesDrawn = drawBoxes;
+			drawBlocks();
+		}
+		bool meshesChanged = updateChunkMeshes() > 0;
+		//the command buffers only need recording again when the buffers they draw have changed
+		if (verticesChanged || meshesChanged) {
+			//getting image from swap chain
+			//drawRect(-20, -2.5, 40, 5, 0, 1, 0);
+			//drawRect(-2.5, -20, 5, 40, 0, 1, 0);
+			for (int i = 0; i < 500; i++) {
+				//addVectors(&vertices, &indices, &verticesInverterModel, &indicesInverterModel);
+			}
+
+			//vulkan doesn't allow empty buffers, and the frames in flight read the old ones so they have to finish first
+			if (verticesChanged && !indices.empty()) {
+				waitForFrames();
+				createVertexBuffer(vertices, vertexBuffer, vertexBufferMemory);
+				createIndexBuffer(indices, indexBuffer, indexBufferMemory);
+			}
+			createCommandBuffers();
+			verticesChanged = false;
+		}
+
+
+		//everything uploaded for this frame goes in one submission ahead of the draw, also when the frame is dropped below
+		stagingRing.flush();
+
+		uint32_t imageIndex;
+
+		//checking if the swap chain is out of date using vulkan
+		VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			recreateSwapChain();
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+			throw std::runtime_error("failed to acquire swap chain image!");
+		}
+		//the last frame drawn to this image reads the same slot, so it has to be done before the slot is written, coherent memory needs no flush
+		if (imageFences[imageIndex] != VK_NULL_HANDLE) {
+			vkWaitForFences(device, 1, &imageFences[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+		imageFences[imageIndex] = frameFences[currentFrame];
+		memcpy((char*)uniformBufferMemory.getMapped() + uniformSlotSize * imageIndex, &frameUniforms, sizeof(frameUniforms));
+
+		//submitting the command buffer
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = waitSemaphores;
+		submitInfo.pWaitDstStageMask = waitStages;
+
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+
+		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		vkResetFences(device, 1, &frameFences[currentFrame]);
+		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, frameFences[currentFrame]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}
+		//last step: submitting the result back to the swap chain so it is shown on the screen
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = signalSemaphores;
+
+		VkSwapchainKHR swapChains[] = { swapChain };
+
+		//number of swapchains(should be 1 always)
+		presentInfo.swapchainCount = 1;
+
+		//the actualy swapchain being used
+		presentInfo.pSwapchains = swapChains;
+
+		//the index of the image to be presented from the swapchain
+		presentInfo.pImageIndices = &imageIndex;
+
+		//presenting the swapchain image to the presentation engine (vsync/mailbox)
+		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+			recreateSwapChain();
+		}
+		else if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to present swap chain image!");
+		}
+		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	}
+
+	void createInstance() {
+		if (enableValidationLayers && !checkValidationLayerSupport()) {
+			throw std::runtime_error("validation layers requested, but not available!");
+		}
+		//optional struct with general infro about the application
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Hello Triangle";
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "No Engine";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = VK_API_VERSION_1_0;
+		//non optional struct to define which global extensions and validation layers to use
+		VkInstanceCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInfo.pApplicationInfo = &appInfo;
+
+		auto extensions = getRequiredExtensions();
+		createInfo.enabledExtensionCount = extensions.size();
+		createInfo.ppEnabledExtensionNames = extensions.data();
+		//includes validation layer names if they are enabled
+		if (enableValidationLayers) {
+			createInfo.enabledLayerCount = validationLayers.size();
+			createInfo.ppEnabledLayerNames = validationLayers.data();
+		}
+		else {
+			createInfo.enabledLayerCount = 0;
+		}
+		//simple error check for success
+		if (vkCreateInstance(&createInfo, nullptr, instance.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create instance!");
+		}
+	}
+
+	void setupDebugCallback() {
+		if (!enableValidationLayers) return;
+
+		VkDebugReportCallbackCreateInfoEXT createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
+		createInfo.flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT;
+		createInfo.pfnCallback = debugCallback;
+
+		if (CreateDebugReportCallbackEXT(instance, &createInfo, nullptr, callback.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to set up debug callback!");
+		}
+	}
+
+	void createSurface() {
+		if (glfwCreateWindowSurface(instance, window, nullptr, surface.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create window surface!");
+		}
+	}
+	//picking a suitable physical device
+	void pickPhysicalDevice() {
+		//VkPhysicalDevice is a handle to a device(gfx card)
+		//listing graphics cards
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+		//error checking for if there is even a graphics card there
+		if (deviceCount == 0) {
+			throw std::runtime_error("failed to find GPUs with Vulkan support!");
+		}
+		//creating an vector to hold all the VkPhysicalDevice handles
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+		//looping through the vector see see if each graphics card is suitable
+		for (const auto& device : devices) {
+			if (isDeviceSuitable(device)) {
+				physicalDevice = device;
+				break;
+			}
+		}
+		//error handling for if no suitable card is found
+		if (physicalDevice == VK_NULL_HANDLE) {
+			throw std::runtime_error("failed to find a suitable GPU!");
+		}
+	}
+	//creating a logical device to interface with the physical device
+	void createLogicalDevice() {
+		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+
+		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+		std::set<int> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+		if (indices.transferFamily >= 0) {
+			uniqueQueueFamilies.insert(indices.transferFamily);
+		}
+
+		float queuePriority = 1.0f;
+		for (int queueFamily : uniqueQueueFamilies) {
+			VkDeviceQueueCreateInfo queueCreateInfo = {};
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueFamilyIndex = queueFamily;
+			queueCreateInfo.queueCount = 1;
+			queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfos.push_back(queueCreateInfo);
+		}
+
+		VkPhysicalDeviceFeatures deviceFeatures = {};
+
+		VkDeviceCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+
+		createInfo.pQueueCreateInfos = queueCreateInfos.data();
+		createInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
+
+		createInfo.pEnabledFeatures = &deviceFeatures;
+
+		createInfo.enabledExtensionCount = deviceExtensions.size();
+		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+		if (enableValidationLayers) {
+			createInfo.enabledLayerCount = validationLayers.size();
+			createInfo.ppEnabledLayerNames = validationLayers.data();
+		}
+		else {
+			createInfo.enabledLayerCount = 0;
+		}
+		//instantiating the logical device, with a small error check
+		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, device.replace()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create logical device!");
+		}
+
+		vkGetDeviceQueue(device, indices.graphicsFamily, 0, &graphicsQueue);
+		vkGetDeviceQueue(device, indices.presentFamily, 0, &presentQueue);
+		if (indices.transferFamily >= 0) {
+			vkGetDeviceQueue(device, indices.transferFamily, 0, &transferQueue);
+		}
+	}
+
+	void createSwapChain() {
+		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice);
+
+		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
+		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+		VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
+		//number of images in the swap chain
+		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+		if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
+			imageCount = swapChainSupport.capabilities.maxImageCount;
+		}
+
+		VkSwapchainCreateInfoKHR createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		createInfo.surface = surface;
+		//swap chain details
+		createInfo.minImageCount = imageCount;
+		createInfo.imageFormat = surfaceFormat.format;
+		createInfo.imageColorSpace = surfaceFormat.colorSpace;
+		createInfo.imageExtent = extent;
+		createInfo.imageArrayLayers = 1; //always 1 unless stereoscopic 3D application
+		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; //what we will be usin g the images in the swapchain for
+
+		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+		uint32_t queueFamilyIndices[] = { (uint32_t)indices.graphicsFamily, (uint32_t)indices.presentFamily };
+
+		if (indices.graphicsFamily != indices.presentFamily) {
+			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT; //images can be used with multiple queue families without transfer
+			createInfo.queueFamilyIndexCount = 2;
+			createInfo.pQueueFamilyIndices = queueFamilyIndices;
+		}
+		else {
+			createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;//images can not be used with multiple queue families unless transfered
+			createInfo.queueFamilyIndexCount = 0; // Optional
+			createInfo.pQueueFamilyIndices = nullptr; // Optional
+		}
+
+		createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		createInfo.presentMode = presentMode;
+		createInfo.clipped = VK_TRUE;
+
+		VkSwapchainKHR oldSwapChain = swapChain;
+		createInfo.oldSwapchain = oldSwapChain;
+
+		VkSwapchainKHR newSwapChain;
+		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &newSwapChain) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create swap chain!");
+		}
+
+		swapChain = newSwapChain;
+
+		vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr);
+		swapChainImages.resize(imageCount);
+		vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data());
+
+		swapChainImageFormat = surfaceFormat.format;
+		swapChainExtent = extent;
+	}
+
+	void createImageViews() {
+		swapChainImageViews.resize(swapChainImages.size(), VDeleter<VkImageView>{device, vkDestroyImageView});
+
+		for (uint32_t i = 0; i < swapChainImages.size(); i++) {
+			createImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, swapChainImageViews[i]);
+		}
+	}
 
-			if (keys.f) {
-				//std::cout << "BLOCKS: " << blocks.getVectorSize() << std::endl;
-				verticesChanged = true;
-				blocks.addBlock(cameraMin.x, cameraMin.y - 1, cameraMin.z, blockSelected);
-			}
-			
-			glm::vec3 test = cameraMin;
-			//blocks.correctCameraWithBlocks(&cameraMin, &cameraMax, &cameraVel);
-			cameraMax += cameraVel;
-			cameraMin += cameraVel;
-			cameraPosition = cameraMin + cameraOffset;
-			if (inFocus) {
-				glfwGetCursorPos(window, &xpos, &ypos);
-				glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
-				cameraAngle.x += 0.003 * float(WIDTH / 2 - xpos);
-				cameraAngle.y += 0.003 * float(HEIGHT / 2 - ypos);
-				if (cameraAngle.y < -3.14 / 2) {
-					cameraAngle.y = -3.14 / 2;
-				}
-				if (cameraAngle.y > 3.14 / 2) {
-					cameraAngle.y = 3.14 / 2;
-				}
-			}
-			drawFrame();
-			vkDeviceWaitIdle(device);
-			//std::cout << "temp: " << temp << ", time: " << time << ", delay: " << delay << ", temp - time: " << temp - time << std::endl;
-			float delay = 1.0f / 60.0f;
-			float temp = glfwGetTime();
-			
-			
-			if (temp - time < delay) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(int(1000 * (delay - (temp - time)))));
-				
+	//choosing a swap chain format
+	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
+		if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED) {
+			return{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+		}
+
+		for (const auto& availableFormat : availableFormats) {
+			if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+				return availableFormat;
 			}
-			else {
-				std::cout << "FRAME DROP" << std::endl;
-				std::cout << "BLOCKS: " << blocks.getVectorSize() << std::endl;
+		}
+
+		return availableFormats[0];
+	}
+	//presentation mode: represents the actual conditions for showing images on the screen, 
+	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes) {
+		for (const auto& availablePresentMode : availablePresentModes) {
+			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+				return availablePresentMode;
 			}
-			time = glfwGetTime();
 		}
+		//this mode is always avaivable, last resort
+		return VK_PRESENT_MODE_FIFO_KHR;
 	}
+	//choosing resolution of the swap chain
+	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
+		if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+			return capabilities.currentExtent;
+		}
+		else {
+			VkExtent2D actualExtent = { WIDTH, HEIGHT };
 
-	glm::vec3 direction;
+			actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
+			actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
 
-	glm::vec3 right;
+			return actualExtent;
+		}
+	}
 
-	glm::vec3 up;
-	
-	float FOV = 90;
+	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) {
+		SwapChainSupportDetails details;
+		//filling the struct with the basic capibilities
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+		//getting supported surface formats
+		uint32_t formatCount;
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
 
-	void updateUniformBuffer() {
-		static auto startTime = std::chrono::high_resolution_clock::now();
+		if (formatCount != 0) {
+			details.formats.resize(formatCount);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+		}
+		//getting supported presentation modes
+		uint32_t presentModeCount;
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
 
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		float time = 0;// std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
+		if (presentModeCount != 0) {
+			details.presentModes.resize(presentModeCount);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+		}
 
-		direction = glm::vec3(
-			cos(cameraAngle.y) * sin(cameraAngle.x),
-			sin(cameraAngle.y),
-			cos(cameraAngle.y) * cos(cameraAngle.x)
-		);
+		return details;
+	}
+	//checking a graphics card to see if it suitable
+	bool isDeviceSuitable(VkPhysicalDevice device) {
+		//checking queue families
+		QueueFamilyIndices indices = findQueueFamilies(device);
+		//checking if extensions are supported
+		bool extensionsSupported = checkDeviceExtensionSupport(device);
+		//checking swap chain
+		bool swapChainAdequate = false;
+		if (extensionsSupported) {
+			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
+			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+		}
 
-		right = glm::vec3(
-			sin(cameraAngle.x - 3.14f / 2.0f),
-			0,
-			cos(cameraAngle.x - 3.14f / 2.0f)
-		);
+		return indices.isComplete() && extensionsSupported && swapChainAdequate;
+	}
+	//goes through all extensions and checks is the required ones are there
+	bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
-		up = glm::cross(right, direction);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-		UniformBufferObject ubo = {};
-		ubo.model = glm::rotate(glm::mat4(), 0.0f, glm::vec3(0, 0, 1));
-		ubo.view = glm::lookAt(cameraPosition, cameraPosition + direction, up);
-		ubo.proj = glm::perspective(glm::radians(FOV), swapChainExtent.width / (float)swapChainExtent.height, 0.001f, 1000.0f);
-		ubo.proj[1][1] *= -1;
-		ubo.time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - startTime).count() / 1000.0f;
-		void* data;
-		vkMapMemory(device, uniformStagingBufferMemory, 0, sizeof(ubo), 0, &data);
-		memcpy(data, &ubo, sizeof(ubo));
-		vkUnmapMemory(device, uniformStagingBufferMemory);
+		std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
-		copyBuffer(uniformStagingBuffer, uniformBuffer, sizeof(ubo));
-	}
-	void drawRect(float x, float y, float width, float height, float r, float g, float b) {
-		x /= swapChainExtent.width;
-		width /= swapChainExtent.width;
-		y /= swapChainExtent.height;
-		height /= swapChainExtent.height;
-		Vertex temp = {};
-		temp.texCoord = { 0.111, 0 };
-		temp.pos = glm::vec3(x, y, 0);
-		temp.color = { r, g, b };
-		vertices.push_back(temp);
-		temp.pos = glm::vec3(x, y + height, 0);
-		vertices.push_back(temp);
-		temp.pos = glm::vec3(x + width, y + height, 0);
-		vertices.push_back(temp);
-		temp.pos = glm::vec3(x + width, y, 0);
-		vertices.push_back(temp);
-		indices.push_back(vertices.size() - 4);
-		indices.push_back(vertices.size() - 3);
-		indices.push_back(vertices.size() - 2);
+		for (const auto& extension : availableExtensions) {
+			requiredExtensions.erase(extension.extensionName);
+		}
 
-		indices.push_back(vertices.size() - 4);
-		indices.push_back(vertices.size() - 2);
-		indices.push_back(vertices.size() - 1);
+		return requiredExtensions.empty();
 	}
-	bool verticesChanged = false;
-	//gets the image from the swap chain, executes the command buffer, with the swapchain image in the framebuffer, returns the image to the swap chain for presentation
-	void drawFrame() {
-		//if (verticesChanged) {
-		if (keys.n6) {
-			vertices.clear();
-			indices.clear();
-			drawBlocks();
-		}
-			//getting image from swap chain
-			//drawRect(-20, -2.5, 40, 5, 0, 1, 0);
-			//drawRect(-2.5, -20, 5, 40, 0, 1, 0);
-			for (int i = 0; i < 500; i++) {
-				//addVectors(&vertices, &indices, &verticesInverterModel, &indicesInverterModel);
-			}
 
+	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) {
+		QueueFamilyIndices indices;
+		//getting the list of queue families
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+		//filling a vector with queue families
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+		//checking if atleast one of them is usable, supports VK_QUEUE_GRAPHICS_BIT
+		int i = 0;
+		for (const auto& queueFamily : queueFamilies) {
+			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				indices.graphicsFamily = i;
+			}
 
-			createVertexBuffer(vertices, vertexBuffer, vertexBufferMemory);
-			createIndexBuffer(indices, indexBuffer, indexBufferMemory);
-			createCommandBuffers();
-			verticesChanged = false;
-		//}
+			VkBool32 presentSupport = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
+			if (queueFamily.queueCount > 0 && presentSupport) {
+				indices.presentFamily = i;
+			}
 
-		uint32_t imageIndex;
+			if (indices.isComplete()) {
+				break;
+			}
 
-		//checking if the swap chain is out of date using vulkan
-		VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-			recreateSwapChain();
-			return;
+			i++;
 		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-			throw std::runtime_error("failed to acquire swap chain image!");
+		//a family that can't do graphics or compute is usually the dma engine, copies there run alongside rendering
+		int fallback = -1;
+		for (i = 0; i < (int)queueFamilies.size(); i++) {
+			VkQueueFlags flags = queueFamilies[i].queueFlags;
+			if (queueFamilies[i].queueCount == 0 || i == indices.graphicsFamily || !(flags & VK_QUEUE_TRANSFER_BIT)) {
+				continue;
+			}
+			if (!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+				indices.transferFamily = i;
+				break;
+			}
+			if (fallback < 0 && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+				fallback = i;
+			}
+		}
+		if (indices.transferFamily < 0) {
+			indices.transferFamily = fallback;
 		}
 
-		//submitting the command buffer
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-		VkSemaphore waitSemaphores[] = { imageAvailableSemaphore };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
-
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+		return indices;
+	}
+	//returns the required list of extensions based on the validation layers are enabled or not 
+	std::vector<const char*> getRequiredExtensions() {
+		std::vector<const char*> extensions;
 
-		VkSemaphore signalSemaphores[] = { renderFinishedSemaphore };
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		unsigned int glfwExtensionCount = 0;
+		const char** glfwExtensions;
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
-			throw std::runtime_error("failed to submit draw command buffer!");
+		for (unsigned int i = 0; i < glfwExtensionCount; i++) {
+			extensions.push_back(glfwExtensions[i]);
 		}
-		//last step: submitting the result back to the swap chain so it is shown on the screen
-		VkPresentInfoKHR presentInfo = {};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+		if (enableValidationLayers) {
+			extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+		}
 
-		VkSwapchainKHR swapChains[] = { swapChain };
+		return extensions;
+	}
 
-		//number of swapchains(should be 1 always)
-		presentInfo.swapchainCount = 1;
+	bool checkValidationLayerSupport() {
+		uint32_t layerCount;
+		vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
 
-		//the actualy swapchain being used
-		presentInfo.pSwapchains = swapChains;
+		std::vector<VkLayerProperties> availableLayers(layerCount);
+		vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
 
-		//the index of the image to be presented from the swapchain
-		presentInfo.pImageIndices = &imageIndex;
+		for (const char* layerName : validationLayers) {
+			bool layerFound = false;
 
-		//presenting the swapchain image to the presentation engine (vsync/mailbox)
-		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+			for (const auto& layerProperties : availableLayers) {
+				if (strcmp(layerName, layerProperties.layerName) == 0) {
+					layerFound = true;
+					break;
+				}
+			}
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-			recreateSwapChain();
-		}
-		else if (result != VK_SUCCESS) {
-			throw std::runtime_error("failed to present swap chain image!");
+			if (!layerFound) {
+				return false;
+			}
 		}
+
+		return true;
 	}
 
-	void createInstance() {
-		if (enableValidationLayers && !checkValidationLayerSupport()) {
-			throw std::runtime_error("validation layers requested, but not available!");
-		}
-		//optional struct with general infro about the application
-		VkApplicationInfo appInfo = {};
-		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-		appInfo.pApplicationName = "Hello Triangle";
-		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.pEngineName = "No Engine";
-		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
-		//non optional struct to define which global extensions and validation layers to use
-		VkInstanceCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-		createInfo.pApplicationInfo = &appInfo;
+	static std::vector<char> readFile(const std::string& filename) {
+		std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
-		auto extensions = getRequiredExtensions();
-		createInfo.enabledExtensionCount = extensions.size();
-		createInfo.ppEnabledExtensionNames = extensions.data();
-		//includes validation layer names if they are enabled
-		if (enableValidationLayers) {
-			createInfo.enabledLayerCount = validationLayers.size();
-			createInfo.ppEnabledLayerNames = validationLayers.data();
-		}
-		else {
-			createInfo.enabledLayerCount = 0;
-		}
-		//simple error check for success
-		if (vkCreateInstance(&createInfo, nullptr, instance.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create instance!");
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file!");
 		}
+		//determining size and allocating a buffer
+		size_t fileSize = (size_t)file.tellg();
+		std::vector<char> buffer(fileSize);
+		//reading the file
+		file.seekg(0);
+		file.read(buffer.data(), fileSize);
+		//closing file and returning the bytes
+		file.close();
+		return buffer;
 	}
 
-	void setupDebugCallback() {
-		if (!enableValidationLayers) return;
+	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objType, uint64_t obj, size_t location, int32_t code, const char* layerPrefix, const char* msg, void* userData) {
+		std::cerr << "validation layer: " << msg << std::endl;
 
-		VkDebugReportCallbackCreateInfoEXT createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
-		createInfo.flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT;
-		createInfo.pfnCallback = debugCallback;
+		return VK_FALSE;
+	}
+};
 
-		if (CreateDebugReportCallbackEXT(instance, &createInfo, nullptr, callback.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to set up debug callback!");
+//times six neighbour lookups per block against reading the stored neighbour masks, which is what drawBlocks does for wires now
+//the density is kept constant so the time per block should stay flat if lookups are O(1), both ways should count the same neighbours
+void benchmarkBlockRebuild() {
+	for (int blockCount = 1000; blockCount <= 1000000; blockCount *= 10) {
+		Blocks blocks;
+		int size = (int)cbrt(blockCount * 4.0);
+		while (blocks.getVectorSize() < blockCount) {
+			blocks.addBlock(rand() % size, rand() % size, rand() % size, wire);
 		}
-	}
 
-	void createSurface() {
-		if (glfwCreateWindowSurface(instance, window, nullptr, surface.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create window surface!");
+		auto startTime = std::chrono::high_resolution_clock::now();
+		int neighbours = 0;
+		for (auto& chunkEntry : blocks.chunks) {
+			for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+				if (!chunkEntry.second->occupied[cell]) {
+					continue;
+				}
+				glm::vec3 position = chunkEntry.second->getBlock(cell).position;
+				neighbours += blocks.doesBlockExist(position.x, position.y - 1, position.z);
+				neighbours += blocks.doesBlockExist(position.x, position.y + 1, position.z);
+				neighbours += blocks.doesBlockExist(position.x, position.y, position.z - 1);
+				neighbours += blocks.doesBlockExist(position.x, position.y, position.z + 1);
+				neighbours += blocks.doesBlockExist(position.x - 1, position.y, position.z);
+				neighbours += blocks.doesBlockExist(position.x + 1, position.y, position.z);
+			}
 		}
-	}
-	//picking a suitable physical device
-	void pickPhysicalDevice() {
-		//VkPhysicalDevice is a handle to a device(gfx card)
-		//listing graphics cards
-		uint32_t deviceCount = 0;
-		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-		//error checking for if there is even a graphics card there
-		if (deviceCount == 0) {
-			throw std::runtime_error("failed to find GPUs with Vulkan support!");
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+		startTime = std::chrono::high_resolution_clock::now();
+		int maskNeighbours = 0;
+		for (auto& chunkEntry : blocks.chunks) {
+			for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+				if (chunkEntry.second->occupied[cell]) {
+					maskNeighbours += (int)std::bitset<6>(chunkEntry.second->neighbours[cell]).count();
+				}
+			}
 		}
-		//creating an vector to hold all the VkPhysicalDevice handles
-		std::vector<VkPhysicalDevice> devices(deviceCount);
-		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
-		//looping through the vector see see if each graphics card is suitable
-		for (const auto& device : devices) {
-			if (isDeviceSuitable(device)) {
-				physicalDevice = device;
-				break;
+		endTime = std::chrono::high_resolution_clock::now();
+		double maskMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+		std::cout << "rebuild " << blockCount << " blocks: lookups " << ms << " ms, " << (ms * 1000000.0 / blockCount) << " ns/block (" << neighbours << " neighbours), masks " << maskMs << " ms, " << (maskMs * 1000000.0 / blockCount) << " ns/block (" << maskNeighbours << " neighbours)" << std::endl;
+	}
+}
+
+//reports the memory the block storage uses per block for a million block world, both packed solid and scattered
+void benchmarkBlockMemory() {
+	for (int scattered = 0; scattered < 2; scattered++) {
+		Blocks blocks;
+		if (scattered) {
+			while (blocks.getVectorSize() < 1000000) {
+				blocks.addBlock(rand() % 400, rand() % 400, rand() % 400, wire);
 			}
 		}
-		//error handling for if no suitable card is found
-		if (physicalDevice == VK_NULL_HANDLE) {
-			throw std::runtime_error("failed to find a suitable GPU!");
+		else {
+			for (int x = 0; x < 100; x++) {
+				for (int y = 0; y < 100; y++) {
+					for (int z = 0; z < 100; z++) {
+						blocks.addBlock(x, y, z, wire);
+					}
+				}
+			}
 		}
+		size_t bytes = blocks.getMemoryUsage();
+		std::cout << (scattered ? "scattered" : "solid") << " 1M block world: " << blocks.chunks.size() << " chunks, " << bytes / 1048576.0 << " MB, " << bytes / (double)blocks.getVectorSize() << " bytes/block (Block record: " << sizeof(Block) << " bytes)" << std::endl;
 	}
-	//creating a logical device to interface with the physical device
-	void createLogicalDevice() {
-		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+}
 
-		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<int> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+//removes every block through its handle in random order, the time per removal should stay flat as the world grows
+void benchmarkBlockRemoval() {
+	for (int blockCount = 1000; blockCount <= 1000000; blockCount *= 10) {
+		Blocks blocks;
+		std::vector<BlockHandle> handles;
+		int size = (int)cbrt(blockCount * 4.0);
+		while (blocks.getVectorSize() < blockCount) {
+			BlockHandle handle = blocks.addBlock(rand() % size, rand() % size, rand() % size, wire);
+			if (handle.isValid()) {
+				handles.push_back(handle);
+			}
+		}
+		std::shuffle(handles.begin(), handles.end(), std::mt19937(1));
 
-		float queuePriority = 1.0f;
-		for (int queueFamily : uniqueQueueFamilies) {
-			VkDeviceQueueCreateInfo queueCreateInfo = {};
-			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queueCreateInfo.queueFamilyIndex = queueFamily;
-			queueCreateInfo.queueCount = 1;
-			queueCreateInfo.pQueuePriorities = &queuePriority;
-			queueCreateInfos.push_back(queueCreateInfo);
+		auto startTime = std::chrono::high_resolution_clock::now();
+		int removed = 0;
+		for (size_t i = 0; i < handles.size(); i++) {
+			removed += blocks.removeBlock(handles[i]);
 		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		VkPhysicalDeviceFeatures deviceFeatures = {};
+		//every handle is stale now, none of them should remove anything
+		int staleRemoved = blocks.removeBlock(handles[0]);
+		std::cout << "remove " << blockCount << " blocks: " << ms << " ms, " << (ms * 1000000.0 / blockCount) << " ns/block (" << removed << " removed, " << staleRemoved << " stale removed)" << std::endl;
+	}
+}
 
-		VkDeviceCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+//fills, copies, pastes (turned each way) and clears a 64x8x64 box through the region calls and compares with adding the same blocks one by one
+void benchmarkRegionEdits() {
+	glm::ivec3 min = glm::ivec3(-32, 0, -32);
+	glm::ivec3 max = glm::ivec3(31, 7, 31);
+	Blocks blocks;
 
-		createInfo.pQueueCreateInfos = queueCreateInfos.data();
-		createInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (int x = min.x; x <= max.x; x++) {
+		for (int y = min.y; y <= max.y; y++) {
+			for (int z = min.z; z <= max.z; z++) {
+				blocks.addBlock(x, y, z, wire, positiveX);
+			}
+		}
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double singleMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+	blocks.clearRegion(min, max);
 
-		createInfo.pEnabledFeatures = &deviceFeatures;
+	startTime = std::chrono::high_resolution_clock::now();
+	int filled = blocks.fillRegion(min, max, wire, positiveX);
+	BlockClipboard clipboard;
+	blocks.copyRegion(min, max, &clipboard);
+	int pasted = 0;
+	for (int quarterTurns = 0; quarterTurns < 4; quarterTurns++) {
+		pasted += blocks.pasteRegion(clipboard, glm::ivec3(100 * (quarterTurns + 1), 0, 0), quarterTurns);
+	}
+	int cleared = blocks.clearRegion(glm::ivec3(-100, -100, -100), glm::ivec3(500, 100, 100));
+	endTime = std::chrono::high_resolution_clock::now();
+	double regionMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		createInfo.enabledExtensionCount = deviceExtensions.size();
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	std::cout << "region edits: one by one fill " << singleMs << " ms, fill + copy + 4 pastes + clear " << regionMs << " ms (" << filled << " filled, " << pasted << " pasted, " << cleared << " cleared, " << blocks.chunks.size() << " chunks left)" << std::endl;
+}
 
-		if (enableValidationLayers) {
-			createInfo.enabledLayerCount = validationLayers.size();
-			createInfo.ppEnabledLayerNames = validationLayers.data();
+//counts neighbours for every block by walking the dense blocks, six lookups each like collision or a netlist pass would do
+int countNeighbours(Blocks& blocks) {
+	int neighbours = 0;
+	for (const Block& block : blocks.getBlocks()) {
+		glm::ivec3 position = block.position;
+		neighbours += blocks.doesBlockExist(position.x, position.y - 1, position.z);
+		neighbours += blocks.doesBlockExist(position.x, position.y + 1, position.z);
+		neighbours += blocks.doesBlockExist(position.x, position.y, position.z - 1);
+		neighbours += blocks.doesBlockExist(position.x, position.y, position.z + 1);
+		neighbours += blocks.doesBlockExist(position.x - 1, position.y, position.z);
+		neighbours += blocks.doesBlockExist(position.x + 1, position.y, position.z);
+	}
+	return neighbours;
+}
+
+//neighbour query throughput over the dense blocks in insertion order and after sorting them along the z-order curve
+//the random world scatters 1M blocks through a 160^3 box, the circuit world packs them into 8x4x8 clusters added in random order
+void benchmarkMortonOrder() {
+	for (int circuit = 0; circuit < 2; circuit++) {
+		std::vector<glm::ivec3> positions;
+		if (circuit) {
+			while (positions.size() < 1000000) {
+				glm::ivec3 corner = glm::ivec3(rand() % 1000, rand() % 100, rand() % 1000);
+				for (int x = 0; x < 8; x++) {
+					for (int y = 0; y < 4; y++) {
+						for (int z = 0; z < 8; z++) {
+							positions.push_back(corner + glm::ivec3(x, y, z));
+						}
+					}
+				}
+			}
 		}
 		else {
-			createInfo.enabledLayerCount = 0;
+			for (int i = 0; i < 1000000; i++) {
+				positions.push_back(glm::ivec3(rand() % 160, rand() % 160, rand() % 160));
+			}
 		}
-		//instantiating the logical device, with a small error check
-		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, device.replace()) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create logical device!");
+		std::shuffle(positions.begin(), positions.end(), std::mt19937(1));
+		Blocks blocks;
+		for (size_t i = 0; i < positions.size(); i++) {
+			blocks.addBlock(positions[i].x, positions[i].y, positions[i].z, wire);
 		}
 
-		vkGetDeviceQueue(device, indices.graphicsFamily, 0, &graphicsQueue);
-		vkGetDeviceQueue(device, indices.presentFamily, 0, &presentQueue);
-	}
+		auto startTime = std::chrono::high_resolution_clock::now();
+		int insertionNeighbours = countNeighbours(blocks);
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double insertionMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-	void createSwapChain() {
-		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice);
+		startTime = std::chrono::high_resolution_clock::now();
+		blocks.sortBlocks();
+		endTime = std::chrono::high_resolution_clock::now();
+		double sortMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
-		VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
-		//number of images in the swap chain
-		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-		if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-			imageCount = swapChainSupport.capabilities.maxImageCount;
-		}
+		startTime = std::chrono::high_resolution_clock::now();
+		int sortedNeighbours = countNeighbours(blocks);
+		endTime = std::chrono::high_resolution_clock::now();
+		double sortedMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		VkSwapchainCreateInfoKHR createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-		createInfo.surface = surface;
-		//swap chain details
-		createInfo.minImageCount = imageCount;
-		createInfo.imageFormat = surfaceFormat.format;
-		createInfo.imageColorSpace = surfaceFormat.colorSpace;
-		createInfo.imageExtent = extent;
-		createInfo.imageArrayLayers = 1; //always 1 unless stereoscopic 3D application
-		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; //what we will be usin g the images in the swapchain for
+		double count = blocks.getVectorSize();
+		std::cout << (circuit ? "circuit" : "random") << " world " << blocks.getVectorSize() << " blocks: insertion order " << (insertionMs * 1000000.0 / count) << " ns/block, z-order " << (sortedMs * 1000000.0 / count) << " ns/block, sort " << sortMs << " ms (" << insertionNeighbours << "/" << sortedNeighbours << " neighbours)" << std::endl;
+	}
+}
 
-		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
-		uint32_t queueFamilyIndices[] = { (uint32_t)indices.graphicsFamily, (uint32_t)indices.presentFamily };
+//steps along the ray a quarter block at a time, how the chunk map and a flat map have to answer ray queries
+template<typename Exists>
+bool stepRay(glm::vec3 origin, glm::vec3 direction, float maxDistance, Exists exists, glm::ivec3* hit) {
+	direction = glm::normalize(direction);
+	for (float t = 0; t <= maxDistance; t += 0.25f) {
+		glm::ivec3 cell = glm::ivec3(glm::floor(origin + direction * t));
+		if (exists(cell.x, cell.y, cell.z)) {
+			*hit = cell;
+			return true;
+		}
+	}
+	return false;
+}
 
-		if (indices.graphicsFamily != indices.presentFamily) {
-			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT; //images can be used with multiple queue families without transfer
-			createInfo.queueFamilyIndexCount = 2;
-			createInfo.pQueueFamilyIndices = queueFamilyIndices;
+//compares a flat position keyed map, the chunk map and the octree on a sparse world of dense islands in a 1000^3 volume
+//(like the scattered blocks commented out in Blocks::init), reporting memory, point lookups, range queries and rays
+void benchmarkSparseBackends() {
+	std::vector<glm::ivec3> positions;
+	for (int island = 0; island < 300; island++) {
+		glm::ivec3 corner = glm::ivec3(rand() % 1000, rand() % 1000, rand() % 1000) - glm::ivec3(500, 500, 500);
+		for (int x = 0; x < 16; x++) {
+			for (int y = 0; y < 4; y++) {
+				for (int z = 0; z < 16; z++) {
+					positions.push_back(corner + glm::ivec3(x, y, z));
+				}
+			}
 		}
-		else {
-			createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;//images can not be used with multiple queue families unless transfered
-			createInfo.queueFamilyIndexCount = 0; // Optional
-			createInfo.pQueueFamilyIndices = nullptr; // Optional
+	}
+	for (int i = 0; i < 75000; i++) {
+		positions.push_back(glm::ivec3(rand() % 1000, rand() % 1000, rand() % 1000) - glm::ivec3(500, 500, 500));
+	}
+
+	std::unordered_map<uint64_t, uint8_t> flat;
+	Blocks chunked;
+	BlockOctree octree;
+	for (size_t i = 0; i < positions.size(); i++) {
+		flat.emplace(packBlockPosition(positions[i].x, positions[i].y, positions[i].z), packBlock(wire, positiveY));
+		chunked.addBlock(positions[i].x, positions[i].y, positions[i].z, wire);
+		octree.addBlock(positions[i].x, positions[i].y, positions[i].z, wire);
+	}
+	auto flatExists = [&](int x, int y, int z) { return flat.count(packBlockPosition(x, y, z)) != 0; };
+	auto chunkedExists = [&](int x, int y, int z) { return chunked.doesBlockExist(x, y, z); };
+	auto octreeExists = [&](int x, int y, int z) { return octree.doesBlockExist(x, y, z); };
+
+	//half the lookups land on blocks, half on random (nearly always empty) cells
+	std::vector<glm::ivec3> lookups;
+	for (int i = 0; i < 1000000; i++) {
+		lookups.push_back(i & 1 ? positions[rand() % positions.size()] : glm::ivec3(rand() % 1000, rand() % 1000, rand() % 1000) - glm::ivec3(500, 500, 500));
+	}
+	std::vector<glm::ivec3> regions;
+	std::vector<glm::vec3> rayOrigins;
+	std::vector<glm::vec3> rayDirections;
+	for (int i = 0; i < 1000; i++) {
+		regions.push_back(positions[rand() % positions.size()] - glm::ivec3(16, 16, 16));
+		rayOrigins.push_back(glm::vec3(rand() % 1000, rand() % 1000, rand() % 1000) - glm::vec3(500, 500, 500));
+		rayDirections.push_back(glm::vec3(rand() % 201 - 100, rand() % 201 - 100, rand() % 201 - 100) + glm::vec3(0.5f, 0.5f, 0.5f));
+	}
+
+	size_t flatBytes = flat.size() * (sizeof(std::pair<const uint64_t, uint8_t>) + sizeof(void*)) + flat.bucket_count() * sizeof(void*);
+	std::cout << "sparse world " << positions.size() << " adds, " << chunked.getVectorSize() << " blocks: flat " << flatBytes / 1048576.0 << " MB, chunked " << chunked.getMemoryUsage() / 1048576.0 << " MB, octree " << octree.getMemoryUsage() / 1048576.0 << " MB" << std::endl;
+
+	for (int backend = 0; backend < 3; backend++) {
+		const char* names[3] = { "flat", "chunked", "octree" };
+		auto startTime = std::chrono::high_resolution_clock::now();
+		int found = 0;
+		for (size_t i = 0; i < lookups.size(); i++) {
+			glm::ivec3 p = lookups[i];
+			found += backend == 0 ? flatExists(p.x, p.y, p.z) : backend == 1 ? chunkedExists(p.x, p.y, p.z) : octreeExists(p.x, p.y, p.z);
 		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double lookupMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+		//32^3 boxes around existing blocks, the flat map can only check every cell
+		startTime = std::chrono::high_resolution_clock::now();
+		size_t inRegions = 0;
+		std::vector<Block> regionBlocks;
+		for (size_t i = 0; i < regions.size(); i++) {
+			glm::ivec3 min = regions[i];
+			glm::ivec3 max = min + glm::ivec3(31, 31, 31);
+			regionBlocks.clear();
+			if (backend == 0) {
+				for (int x = min.x; x <= max.x; x++) {
+					for (int y = min.y; y <= max.y; y++) {
+						for (int z = min.z; z <= max.z; z++) {
+							inRegions += flatExists(x, y, z);
+						}
+					}
+				}
+			}
+			else if (backend == 1) {
+				chunked.getBlocksInRegion(min, max, &regionBlocks);
+			}
+			else {
+				octree.getBlocksInRegion(min, max, &regionBlocks);
+			}
+			inRegions += regionBlocks.size();
+		}
+		endTime = std::chrono::high_resolution_clock::now();
+		double regionMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+		startTime = std::chrono::high_resolution_clock::now();
+		int hits = 0;
+		for (size_t i = 0; i < rayOrigins.size(); i++) {
+			glm::ivec3 hit;
+			if (backend == 0) {
+				hits += stepRay(rayOrigins[i], rayDirections[i], 1000, flatExists, &hit);
+			}
+			else if (backend == 1) {
+				hits += stepRay(rayOrigins[i], rayDirections[i], 1000, chunkedExists, &hit);
+			}
+			else {
+				hits += octree.raycast(rayOrigins[i], rayDirections[i], 1000, &hit);
+			}
+		}
+		endTime = std::chrono::high_resolution_clock::now();
+		double rayMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
-		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-		createInfo.presentMode = presentMode;
-		createInfo.clipped = VK_TRUE;
-
-		VkSwapchainKHR oldSwapChain = swapChain;
-		createInfo.oldSwapchain = oldSwapChain;
+		std::cout << "  " << names[backend] << ": 1M lookups " << lookupMs << " ms (" << found << " found), 1000 region queries " << regionMs << " ms (" << inRegions << " blocks), 1000 rays " << rayMs << " ms (" << hits << " hits)" << std::endl;
+	}
+}
 
-		VkSwapchainKHR newSwapChain;
-		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &newSwapChain) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create swap chain!");
+//a worker thread keeps counting the blocks of a published snapshot while the main thread edits the live world and republishes
+//every count the worker makes has to match the block count of the snapshot it read, however the edits interleave
+void benchmarkSnapshots() {
+	Blocks blocks;
+	for (int x = 0; x < 100; x++) {
+		for (int y = 0; y < 100; y++) {
+			for (int z = 0; z < 100; z++) {
+				blocks.addBlock(x, y, z, wire);
+			}
+		}
+	}
+	auto startTime = std::chrono::high_resolution_clock::now();
+	blocks.publishSnapshot();
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double snapshotMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+	std::atomic<bool> done(false);
+	int reads = 0;
+	int mismatches = 0;
+	std::thread worker([&]() {
+		while (!done) {
+			std::shared_ptr<const BlockSnapshot> snapshot = blocks.acquireSnapshot();
+			int count = 0;
+			for (auto& chunkEntry : snapshot->chunks) {
+				count += (int)chunkEntry.second->occupied.count();
+			}
+			mismatches += count != snapshot->blockCount;
+			reads++;
 		}
+	});
+
+	startTime = std::chrono::high_resolution_clock::now();
+	int edits = 0;
+	for (int i = 0; i < 100000; i++) {
+		int x = rand() % 100;
+		int y = rand() % 100;
+		int z = rand() % 100;
+		edits += (i & 1) ? blocks.removeBlock(x, y, z) : blocks.addBlock(x, y, z, wire).isValid();
+		if (i % 1000 == 0) {
+			blocks.publishSnapshot();
+		}
+	}
+	endTime = std::chrono::high_resolution_clock::now();
+	double editMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+	done = true;
+	worker.join();
 
-		swapChain = newSwapChain;
+	std::cout << "snapshots: take " << snapshotMs << " ms for " << blocks.chunks.size() << " chunks, 100k edits with a reader " << editMs << " ms (" << edits << " changed, " << blocks.getChunksCopied() << " chunk copies), " << reads << " snapshot reads, " << mismatches << " mismatches" << std::endl;
+}
 
-		vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr);
-		swapChainImages.resize(imageCount);
-		vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data());
+//queries per second for each query type on a million blocks scattered through a 400^3 box, run through the batched calls
+void benchmarkQueries() {
+	Blocks blocks;
+	while (blocks.getVectorSize() < 1000000) {
+		blocks.addBlock(rand() % 400, rand() % 400, rand() % 400, wire);
+	}
+	BlockQueries queries(&blocks);
+
+	const int queryCount = 10000;
+	const int maxResults = 256;
+	const int k = 8;
+	std::vector<glm::ivec3> mins(queryCount);
+	std::vector<glm::ivec3> maxes(queryCount);
+	std::vector<glm::vec3> points(queryCount);
+	std::vector<float> radii(queryCount, 8.0f);
+	std::vector<glm::vec3> directions(queryCount);
+	for (int i = 0; i < queryCount; i++) {
+		mins[i] = glm::ivec3(rand() % 400, rand() % 400, rand() % 400);
+		maxes[i] = mins[i] + glm::ivec3(15, 15, 15);
+		points[i] = glm::vec3(rand() % 40000, rand() % 40000, rand() % 40000) / 100.0f;
+		directions[i] = glm::vec3(rand() % 201 - 100, rand() % 201 - 100, rand() % 201 - 100) + glm::vec3(0.5f, 0.5f, 0.5f);
+	}
+	//every buffer is sized up front, the queries themselves never allocate
+	std::vector<Block> results(queryCount * maxResults);
+	std::vector<int> counts(queryCount);
+	std::vector<glm::ivec3> hits(queryCount);
+	std::vector<glm::ivec3> normals(queryCount);
+	std::unique_ptr<bool[]> found(new bool[queryCount]);
+
+	for (int type = 0; type < 4; type++) {
+		const char* names[4] = { "box 16^3", "sphere r8", "ray 100", "nearest 8" };
+		auto startTime = std::chrono::high_resolution_clock::now();
+		switch (type) {
+		case 0:
+			queries.boxes(mins.data(), maxes.data(), queryCount, results.data(), maxResults, counts.data());
+			break;
+		case 1:
+			queries.spheres(points.data(), radii.data(), queryCount, results.data(), maxResults, counts.data());
+			break;
+		case 2:
+			queries.rays(points.data(), directions.data(), queryCount, 100, hits.data(), normals.data(), found.get());
+			break;
+		case 3:
+			queries.nearests(points.data(), queryCount, k, 64, results.data(), counts.data());
+			break;
+		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		swapChainImageFormat = surfaceFormat.format;
-		swapChainExtent = extent;
+		long long total = 0;
+		for (int i = 0; i < queryCount; i++) {
+			total += type == 2 ? found[i] : counts[i];
+		}
+		std::cout << "query " << names[type] << ": " << (queryCount / ms * 1000.0) << " queries/s (" << total << " results)" << std::endl;
 	}
+}
 
-	void createImageViews() {
-		swapChainImageViews.resize(swapChainImages.size(), VDeleter<VkImageView>{device, vkDestroyImageView});
-
-		for (uint32_t i = 0; i < swapChainImages.size(); i++) {
-			createImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, swapChainImageViews[i]);
-		}
+//cpu side edit-to-visible latency: remeshing every chunk after an edit against remeshing only the dirty chunks
+//(the buffer upload needs a device so it isn't timed, it follows the same split since it's per chunk)
+void benchmarkRemeshLatency() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
 	}
-
-	//choosing a swap chain format
-	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
-		if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED) {
-			return{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+	catch (const std::runtime_error& e) {
+		std::cout << "remesh latency: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint64_t> dirty;
+	for (int blockCount = 1000; blockCount <= 1000000; blockCount *= 10) {
+		Blocks blocks;
+		int size = (int)cbrt(blockCount * 4.0);
+		while (blocks.getVectorSize() < blockCount) {
+			blocks.addBlock(rand() % size, rand() % size, rand() % size, (blockType)(rand() % 5), (blockDirection)(rand() % 6));
 		}
+		blocks.takeDirtyChunks(&dirty);
+		dirty.clear();
 
-		for (const auto& availableFormat : availableFormats) {
-			if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-				return availableFormat;
+		auto startTime = std::chrono::high_resolution_clock::now();
+		size_t fullIndices = 0;
+		for (auto& chunkEntry : blocks.chunks) {
+			vertices.clear();
+			indices.clear();
+			mesher.meshChunk(*chunkEntry.second, &vertices, &indices);
+			fullIndices += indices.size();
+		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double fullMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+		//each edit is followed by remeshing whatever it dirtied, like one frame of drawFrame
+		const int edits = 100;
+		size_t remeshed = 0;
+		startTime = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < edits; i++) {
+			int x = rand() % size;
+			int y = rand() % size;
+			int z = rand() % size;
+			if (!blocks.removeBlock(x, y, z)) {
+				blocks.addBlock(x, y, z, wire);
+			}
+			dirty.clear();
+			blocks.takeDirtyChunks(&dirty);
+			for (size_t j = 0; j < dirty.size(); j++) {
+				auto it = blocks.chunks.find(dirty[j]);
+				vertices.clear();
+				indices.clear();
+				if (it != blocks.chunks.end()) {
+					mesher.meshChunk(*it->second, &vertices, &indices);
+				}
 			}
+			remeshed += dirty.size();
 		}
+		endTime = std::chrono::high_resolution_clock::now();
+		double incrementalMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0 / edits;
 
-		return availableFormats[0];
+		std::cout << "remesh " << blockCount << " blocks: full " << fullMs << " ms (" << blocks.chunks.size() << " chunks, " << fullIndices << " indices), dirty only " << incrementalMs << " ms per edit (" << remeshed / (double)edits << " chunks per edit)" << std::endl;
 	}
-	//presentation mode: represents the actual conditions for showing images on the screen, 
-	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes) {
-		for (const auto& availablePresentMode : availablePresentModes) {
-			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-				return availablePresentMode;
-			}
-		}
-		//this mode is always avaivable, last resort
-		return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+//remeshes every chunk of a 100k block world on the pool at 1, 2, 4, 8 and 16 threads
+//the calling thread acts as the render thread, taking finished meshes like drawFrame does, and its longest "frame" is reported too
+void benchmarkParallelMeshing() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
 	}
-	//choosing resolution of the swap chain
-	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
-		if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-			return capabilities.currentExtent;
+	catch (const std::runtime_error& e) {
+		std::cout << "parallel meshing: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	int size = (int)cbrt(100000 * 4.0);
+	while (blocks.getVectorSize() < 100000) {
+		blocks.addBlock(rand() % size, rand() % size, rand() % size, (blockType)(rand() % 5), (blockDirection)(rand() % 6));
+	}
+	std::vector<uint64_t> keys;
+	for (auto& chunkEntry : blocks.chunks) {
+		keys.push_back(chunkEntry.first);
+	}
+	std::shared_ptr<const BlockSnapshot> snapshot = blocks.getSnapshot();
+
+	double singleMs = 0;
+	for (int threadCount = 1; threadCount <= 16; threadCount *= 2) {
+		ParallelMesher parallelMesher(&mesher, threadCount);
+		std::vector<MeshedChunk> meshes;
+		size_t received = 0;
+		double longestFrameMs = 0;
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		parallelMesher.meshChunks(snapshot, keys, ParallelMesher::copiedMesh);
+		while (received < keys.size()) {
+			auto frameStart = std::chrono::high_resolution_clock::now();
+			parallelMesher.takeCompleted(&meshes);
+			received += meshes.size();
+			auto frameEnd = std::chrono::high_resolution_clock::now();
+			longestFrameMs = std::max(longestFrameMs, std::chrono::duration_cast<std::chrono::microseconds>(frameEnd - frameStart).count() / 1000.0);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+		if (threadCount == 1) {
+			singleMs = ms;
 		}
-		else {
-			VkExtent2D actualExtent = { WIDTH, HEIGHT };
 
-			actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
-			actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
+		std::cout << "parallel meshing " << keys.size() << " chunks, " << threadCount << " threads: " << ms << " ms, " << (keys.size() / ms * 1000.0) << " chunks/s, " << (singleMs / ms) << "x, longest render thread frame " << longestFrameMs << " ms" << std::endl;
+	}
+	std::cout << "  (" << std::thread::hardware_concurrency() << " hardware threads on this machine)" << std::endl;
+}
 
-			return actualExtent;
+//builds every chunk of a 100k block world both ways and compares the cpu time and the bytes each way uploads
+void benchmarkInstancing() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "instancing: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	int size = (int)cbrt(100000 * 4.0);
+	while (blocks.getVectorSize() < 100000) {
+		blocks.addBlock(rand() % size, rand() % size, rand() % size, (blockType)(rand() % 5), (blockDirection)(rand() % 6));
+	}
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (auto& chunkEntry : blocks.chunks) {
+		mesher.meshChunk(*chunkEntry.second, &vertices, &indices);
+	}
+	auto meshTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<BlockInstance> instances;
+	std::vector<uint32_t> instanceCounts;
+	size_t draws = 0;
+	for (auto& chunkEntry : blocks.chunks) {
+		mesher.instanceChunk(*chunkEntry.second, &instances, &instanceCounts);
+		for (size_t p = 0; p < instanceCounts.size(); p++) {
+			draws += instanceCounts[p] > 0;
 		}
 	}
+	auto instanceTime = std::chrono::high_resolution_clock::now();
 
-	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) {
-		SwapChainSupportDetails details;
-		//filling the struct with the basic capibilities
-		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
-		//getting supported surface formats
-		uint32_t formatCount;
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+	std::vector<Vertex> primitiveVertices;
+	std::vector<uint32_t> primitiveIndices;
+	std::vector<BlockMesher::PrimitiveRange> primitiveRanges;
+	mesher.getPrimitiveGeometry(&primitiveVertices, &primitiveIndices, &primitiveRanges);
 
-		if (formatCount != 0) {
-			details.formats.resize(formatCount);
-			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
-		}
-		//getting supported presentation modes
-		uint32_t presentModeCount;
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
+	double meshMs = std::chrono::duration_cast<std::chrono::microseconds>(meshTime - startTime).count() / 1000.0;
+	double instanceMs = std::chrono::duration_cast<std::chrono::microseconds>(instanceTime - meshTime).count() / 1000.0;
+	size_t meshBytes = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t);
+	size_t instanceBytes = instances.size() * sizeof(BlockInstance);
+	size_t primitiveBytes = primitiveVertices.size() * sizeof(Vertex) + primitiveIndices.size() * sizeof(uint32_t);
 
-		if (presentModeCount != 0) {
-			details.presentModes.resize(presentModeCount);
-			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
-		}
+	std::cout << "instancing " << blocks.getVectorSize() << " blocks, " << blocks.chunks.size() << " chunks:" << std::endl;
+	std::cout << "  copied vertices: " << meshMs << " ms, " << (meshBytes / 1024) << " KB (" << vertices.size() << " vertices, " << indices.size() << " indices), " << blocks.chunks.size() << " draws" << std::endl;
+	std::cout << "  instanced:       " << instanceMs << " ms, " << (instanceBytes / 1024) << " KB (" << instances.size() << " instances) + " << (primitiveBytes / 1024) << " KB of primitives once, " << draws << " draws" << std::endl;
+	std::cout << "  " << (meshMs / instanceMs) << "x faster, " << ((double)meshBytes / instanceBytes) << "x less to upload" << std::endl;
+}
 
-		return details;
+//meshes a dense wire-only world, every wire has a few neighbours so most junction shapes show up
+void benchmarkWireMeshing() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "wire meshing: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	int size = (int)cbrt(100000 * 3.0);
+	while (blocks.getVectorSize() < 100000) {
+		blocks.addBlock(rand() % size, rand() % size, rand() % size, wire);
 	}
-	//checking a graphics card to see if it suitable
-	bool isDeviceSuitable(VkPhysicalDevice device) {
-		//checking queue families
-		QueueFamilyIndices indices = findQueueFamilies(device);
-		//checking if extensions are supported
-		bool extensionsSupported = checkDeviceExtensionSupport(device);
-		//checking swap chain
-		bool swapChainAdequate = false;
-		if (extensionsSupported) {
-			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
-			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
-		}
 
-		return indices.isComplete() && extensionsSupported && swapChainAdequate;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (auto& chunkEntry : blocks.chunks) {
+		mesher.meshChunk(*chunkEntry.second, &vertices, &indices);
 	}
-	//goes through all extensions and checks is the required ones are there
-	bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
-		uint32_t extensionCount;
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double ms = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
 
-		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+	std::vector<BlockInstance> instances;
+	std::vector<uint32_t> instanceCounts;
+	for (auto& chunkEntry : blocks.chunks) {
+		mesher.instanceChunk(*chunkEntry.second, &instances, &instanceCounts);
+	}
 
-		std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+	std::cout << "wire meshing " << blocks.getVectorSize() << " wires: " << ms << " ms, " << (indices.size() / 3) << " triangles (" << (indices.size() / 3.0 / blocks.getVectorSize()) << " per wire), " << instances.size() << " instances" << std::endl;
+}
 
-		for (const auto& extension : availableExtensions) {
-			requiredExtensions.erase(extension.extensionName);
+//a flat 100k block circuit board, two layers of wire with rows of gates through it, seen from far away
+//compares the triangles of the full models against culled but unmerged boxes and the greedy box overview
+void benchmarkBoxMode() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "box mode: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	const int width = 224;
+	for (int y = 0; y < 2; y++) {
+		for (int z = 0; z < width; z++) {
+			for (int x = 0; x < width; x++) {
+				blockType type = wire;
+				if (z % 8 == 4 && y == 1) {
+					type = (blockType)(1 + (x / 8) % 4);
+				}
+				blocks.addBlock(x, y, z, type, positiveX);
+			}
 		}
-
-		return requiredExtensions.empty();
 	}
 
-	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) {
-		QueueFamilyIndices indices;
-		//getting the list of queue families
-		uint32_t queueFamilyCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-		//filling a vector with queue families
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
-		//checking if atleast one of them is usable, supports VK_QUEUE_GRAPHICS_BIT
-		int i = 0;
-		for (const auto& queueFamily : queueFamilies) {
-			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-				indices.graphicsFamily = i;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (auto& chunkEntry : blocks.chunks) {
+		mesher.meshChunk(*chunkEntry.second, &vertices, &indices);
+	}
+	auto meshTime = std::chrono::high_resolution_clock::now();
+	size_t modelTriangles = indices.size() / 3;
+
+	vertices.clear();
+	indices.clear();
+	for (auto& chunkEntry : blocks.chunks) {
+		mesher.meshChunkBoxes(*chunkEntry.second, &vertices, &indices);
+	}
+	auto boxTime = std::chrono::high_resolution_clock::now();
+	size_t boxTriangles = indices.size() / 3;
+
+	size_t exposedFaces = 0;
+	for (auto& chunkEntry : blocks.chunks) {
+		const Chunk& chunk = *chunkEntry.second;
+		for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+			if (chunk.occupied[cell]) {
+				exposedFaces += 6 - std::bitset<6>(chunk.neighbours[cell]).count();
 			}
+		}
+	}
 
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+	double meshMs = std::chrono::duration_cast<std::chrono::microseconds>(meshTime - startTime).count() / 1000.0;
+	double boxMs = std::chrono::duration_cast<std::chrono::microseconds>(boxTime - meshTime).count() / 1000.0;
+	std::cout << "box mode " << blocks.getVectorSize() << " blocks: models " << modelTriangles << " triangles in " << meshMs << " ms, culled boxes " << (exposedFaces * 2) << " triangles, greedy boxes " << boxTriangles << " triangles in " << boxMs << " ms (" << (100.0 * boxTriangles / modelTriangles) << "% of the models)" << std::endl;
+}
 
-			if (queueFamily.queueCount > 0 && presentSupport) {
-				indices.presentFamily = i;
+//boards of growing size seen from 20 blocks above one corner of an 800x600 window, counts the triangles every chunk would draw
+//with the full models and with each chunk at the detail chooseChunkDetail gives it
+void benchmarkDetailLevels() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "detail levels: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	float projectionScale = HEIGHT / (2 * tan(glm::radians(90.0f) / 2));
+	glm::vec3 camera(0, 20, 0);
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	for (int width = 128; width <= 1024; width *= 2) {
+		Blocks blocks;
+		for (int z = 0; z < width; z++) {
+			for (int x = 0; x < width; x++) {
+				blockType type = wire;
+				if (z % 8 == 4) {
+					type = (blockType)(1 + (x / 8) % 4);
+				}
+				blocks.addBlock(x, 0, z, type, positiveX);
 			}
-
-			if (indices.isComplete()) {
-				break;
+		}
+		size_t fullTriangles = 0;
+		size_t detailTriangles = 0;
+		int chunkCounts[3] = {};
+		for (auto& chunkEntry : blocks.chunks) {
+			const Chunk& chunk = *chunkEntry.second;
+			detailLevel detail = chooseChunkDetail(chunk, camera, projectionScale);
+			chunkCounts[detail]++;
+			if (detail == boxDetail) {
+				vertices.clear();
+				indices.clear();
+				mesher.meshChunkBoxes(chunk, &vertices, &indices);
+				detailTriangles += indices.size() / 3;
+			}
+			for (int cell = 0; cell < CHUNK_VOLUME; cell++) {
+				if (!chunk.occupied[cell]) {
+					continue;
+				}
+				int primitiveIndex;
+				BlockMesher::orientation primitiveOrientation;
+				mesher.getBlockPrimitive(chunk.getBlock(cell), chunk.neighbours[cell], false, &primitiveIndex, &primitiveOrientation);
+				fullTriangles += mesher.getTriangleCount(primitiveIndex, false);
+				if (detail != boxDetail) {
+					detailTriangles += mesher.getTriangleCount(primitiveIndex, detail == reducedDetail);
+				}
 			}
-
-			i++;
 		}
-
-		return indices;
+		std::cout << "detail levels " << blocks.getVectorSize() << " blocks: full " << fullTriangles << " triangles, with detail levels " << detailTriangles << " (" << chunkCounts[fullDetail] << " full, " << chunkCounts[reducedDetail] << " reduced, " << chunkCounts[boxDetail] << " box chunks)" << std::endl;
 	}
-	//returns the required list of extensions based on the validation layers are enabled or not 
-	std::vector<const char*> getRequiredExtensions() {
-		std::vector<const char*> extensions;
+}
 
-		unsigned int glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+//packs the copied meshes of a 100k block world and compares memory, the worst position error and how long one pass over the vertices takes
+//there is no gpu here, so the pass, which decodes every position like the vertex shader does, stands in for the vertex fetch part of a frame
+void benchmarkPackedVertices() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "packed vertices: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	int size = (int)cbrt(100000 * 4.0);
+	while (blocks.getVectorSize() < 100000) {
+		blocks.addBlock(rand() % size, rand() % size, rand() % size, (blockType)(rand() % 5), (blockDirection)(rand() % 6));
+	}
 
-		for (unsigned int i = 0; i < glfwExtensionCount; i++) {
-			extensions.push_back(glfwExtensions[i]);
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<PackedVertex> packedVertices;
+	std::vector<glm::ivec3> origins;
+	std::vector<size_t> chunkStarts;
+	double packMs = 0;
+	for (auto& chunkEntry : blocks.chunks) {
+		size_t first = vertices.size();
+		mesher.meshChunk(*chunkEntry.second, &vertices, &indices);
+		auto startTime = std::chrono::high_resolution_clock::now();
+		packedVertices.resize(vertices.size());
+		for (size_t v = first; v < vertices.size(); v++) {
+			packedVertices[v] = PackedVertex::pack(vertices[v], chunkEntry.second->origin);
 		}
-
-		if (enableValidationLayers) {
-			extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+		auto endTime = std::chrono::high_resolution_clock::now();
+		packMs += std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+		origins.push_back(chunkEntry.second->origin);
+		chunkStarts.push_back(first);
+	}
+	chunkStarts.push_back(vertices.size());
+
+	float worstError = 0;
+	glm::vec3 fullSum(0);
+	glm::vec3 packedSum(0);
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (size_t v = 0; v < vertices.size(); v++) {
+		fullSum += vertices[v].pos + vertices[v].color;
+	}
+	auto fullTime = std::chrono::high_resolution_clock::now();
+	for (size_t c = 0; c + 1 < chunkStarts.size(); c++) {
+		glm::vec3 origin(origins[c]);
+		for (size_t v = chunkStarts[c]; v < chunkStarts[c + 1]; v++) {
+			const PackedVertex& packed = packedVertices[v];
+			packedSum += glm::vec3(packed.pos[0], packed.pos[1], packed.pos[2]) / PACKED_POSITION_SCALE + origin + glm::vec3(packed.color[0], packed.color[1], packed.color[2]) / 255.0f;
+		}
+	}
+	auto packedTime = std::chrono::high_resolution_clock::now();
+	for (size_t c = 0; c + 1 < chunkStarts.size(); c++) {
+		for (size_t v = chunkStarts[c]; v < chunkStarts[c + 1]; v++) {
+			const PackedVertex& packed = packedVertices[v];
+			glm::vec3 decoded = glm::vec3(packed.pos[0], packed.pos[1], packed.pos[2]) / PACKED_POSITION_SCALE + glm::vec3(origins[c]);
+			worstError = std::max(worstError, glm::length(decoded - vertices[v].pos));
 		}
-
-		return extensions;
 	}
 
-	bool checkValidationLayerSupport() {
-		uint32_t layerCount;
-		vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
-
-		std::vector<VkLayerProperties> availableLayers(layerCount);
-		vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+	double fullMs = std::chrono::duration_cast<std::chrono::microseconds>(fullTime - startTime).count() / 1000.0;
+	double packedMs = std::chrono::duration_cast<std::chrono::microseconds>(packedTime - fullTime).count() / 1000.0;
+	std::cout << "packed vertices " << vertices.size() << " vertices: " << (vertices.size() * sizeof(Vertex) / 1024 / 1024) << " MB -> " << (packedVertices.size() * sizeof(PackedVertex) / 1024 / 1024) << " MB, packing " << packMs << " ms, worst position error " << worstError << " blocks" << std::endl;
+	std::cout << "  one pass over the vertices: " << fullMs << " ms full, " << packedMs << " ms packed (checksums " << glm::length(fullSum) << ", " << glm::length(packedSum) << ")" << std::endl;
+}
 
-		for (const char* layerName : validationLayers) {
-			bool layerFound = false;
+void benchmarkChunkIndices() {
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "chunk indices: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	int size = (int)cbrt(100000 * 4.0);
+	while (blocks.getVectorSize() < 100000) {
+		blocks.addBlock(rand() % size, rand() % size, rand() % size, (blockType)(rand() % 5), (blockDirection)(rand() % 6));
+	}
 
-			for (const auto& layerProperties : availableLayers) {
-				if (strcmp(layerName, layerProperties.layerName) == 0) {
-					layerFound = true;
-					break;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint16_t> shortIndices;
+	std::vector<IndexSection> sections;
+	std::vector<uint32_t> vertexCounts;
+	std::vector<uint32_t> indexCounts;
+	size_t wideBytes = 0;
+	size_t chosenBytes = 0;
+	size_t shortChunks = 0;
+	size_t sectionCount = 0;
+	size_t badIndices = 0;
+	double splitMs = 0;
+	for (auto& chunkEntry : blocks.chunks) {
+		vertices.clear();
+		indices.clear();
+		mesher.meshChunk(*chunkEntry.second, &vertices, &indices);
+		auto startTime = std::chrono::high_resolution_clock::now();
+		bool split = splitShortIndices(indices, &shortIndices, &sections);
+		auto endTime = std::chrono::high_resolution_clock::now();
+		splitMs += std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+		wideBytes += indices.size() * sizeof(uint32_t);
+		if (split) {
+			shortChunks++;
+			sectionCount += sections.size();
+			chosenBytes += shortIndices.size() * sizeof(uint16_t);
+			for (size_t s = 0; s < sections.size(); s++) {
+				for (uint32_t i = sections[s].firstIndex; i < sections[s].firstIndex + sections[s].indexCount; i++) {
+					badIndices += shortIndices[i] + sections[s].vertexBase != indices[i];
 				}
 			}
-
-			if (!layerFound) {
-				return false;
+		}
+		else {
+			sectionCount++;
+			chosenBytes += indices.size() * sizeof(uint32_t);
+		}
+		vertexCounts.push_back((uint32_t)vertices.size());
+		indexCounts.push_back((uint32_t)indices.size());
+	}
+	std::cout << "chunk indices " << blocks.chunks.size() << " chunks: " << shortChunks << " with 16 bit indices in " << sectionCount << " sections, " << (wideBytes / 1024 / 1024) << " MB -> " << (chosenBytes / 1024 / 1024) << " MB of indices, splitting " << splitMs << " ms, " << badIndices << " bad indices" << std::endl;
+
+	//packs the meshes into pages the way the renderer does, then remeshes a quarter of the chunks a few times at slightly different sizes
+	std::vector<RangeAllocator> vertexPages;
+	std::vector<RangeAllocator> indexPages;
+	std::vector<int> pageOf(vertexCounts.size());
+	std::vector<uint32_t> vertexOffsets(vertexCounts.size());
+	std::vector<uint32_t> firstIndices(vertexCounts.size());
+	auto place = [&](size_t c) {
+		for (size_t p = 0; p < vertexPages.size(); p++) {
+			if (!vertexPages[p].allocate(vertexCounts[c], &vertexOffsets[c])) {
+				continue;
+			}
+			if (indexPages[p].allocate(indexCounts[c], &firstIndices[c])) {
+				pageOf[c] = (int)p;
+				return;
+			}
+			vertexPages[p].free(vertexOffsets[c], vertexCounts[c]);
+		}
+		vertexPages.push_back(RangeAllocator(std::max(vertexCounts[c], CHUNK_PAGE_VERTICES)));
+		indexPages.push_back(RangeAllocator(std::max(indexCounts[c], CHUNK_PAGE_INDICES)));
+		vertexPages.back().allocate(vertexCounts[c], &vertexOffsets[c]);
+		indexPages.back().allocate(indexCounts[c], &firstIndices[c]);
+		pageOf[c] = (int)vertexPages.size() - 1;
+	};
+	for (size_t c = 0; c < vertexCounts.size(); c++) {
+		place(c);
+	}
+	size_t firstPages = vertexPages.size();
+	for (int round = 0; round < 20; round++) {
+		for (size_t c = 0; c < vertexCounts.size(); c++) {
+			if (rand() % 4 != 0) {
+				continue;
 			}
+			vertexPages[pageOf[c]].free(vertexOffsets[c], vertexCounts[c]);
+			indexPages[pageOf[c]].free(firstIndices[c], indexCounts[c]);
+			float scale = 0.9f + (rand() % 21) / 100.0f;
+			vertexCounts[c] = (uint32_t)(vertexCounts[c] * scale);
+			indexCounts[c] = vertexCounts[c] / 2 * 3;
+			place(c);
 		}
+	}
+	size_t usedVertices = 0;
+	size_t capacityVertices = 0;
+	size_t freeRanges = 0;
+	for (size_t p = 0; p < vertexPages.size(); p++) {
+		usedVertices += vertexPages[p].getUsed();
+		capacityVertices += vertexPages[p].getCapacity();
+		freeRanges += vertexPages[p].getFreeRangeCount();
+	}
+	std::cout << "  " << (vertexCounts.size() * 2) << " buffers at two per chunk -> " << (firstPages * 2) << " in " << firstPages << " pages, after 20 remesh rounds " << vertexPages.size() << " pages " << (100.0 * usedVertices / capacityVertices) << "% full with " << freeRanges << " gaps" << std::endl;
+}
 
-		return true;
+void benchmarkMeshOptimisation() {
+	const char* models[] = { "AndGate", "OrGate", "XorGate", "inverter", "wire", "wire2", "wire_center", "squareWire", "wiretest", "box", "test",
+		"component", "component2", "component3", "component_gate", "logic_gate_1", "xyzOrigin", "binary_adder" };
+	BlockMesher mesher;
+	for (const char* name : models) {
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		try {
+			mesher.loadModel(&vertices, &indices, std::string("models/") + name + ".obj", glm::vec3(0.5, 0.5, 0.5));
+		}
+		catch (const std::runtime_error& e) {
+			std::cout << "mesh optimisation " << name << ": skipped (" << e.what() << ")" << std::endl;
+			continue;
+		}
+		MeshCacheStats before = analyzeMesh(indices, vertices.size(), sizeof(Vertex));
+		std::vector<Vertex> optimizedVertices = vertices;
+		std::vector<uint32_t> optimizedIndices = indices;
+		std::vector<uint32_t> order;
+		auto startTime = std::chrono::high_resolution_clock::now();
+		optimizeMesh(&optimizedVertices, &optimizedIndices, &order);
+		auto endTime = std::chrono::high_resolution_clock::now();
+		MeshCacheStats after = analyzeMesh(optimizedIndices, optimizedVertices.size(), sizeof(Vertex));
+
+		//the same triangles have to come out, only their order and the vertex numbering may change
+		std::vector<std::array<float, 9>> beforeTriangles;
+		std::vector<std::array<float, 9>> afterTriangles;
+		for (size_t t = 0; t < indices.size() / 3; t++) {
+			std::array<float, 9> a;
+			std::array<float, 9> b;
+			for (int k = 0; k < 3; k++) {
+				for (int axis = 0; axis < 3; axis++) {
+					a[k * 3 + axis] = vertices[indices[t * 3 + k]].pos[axis];
+					b[k * 3 + axis] = optimizedVertices[optimizedIndices[t * 3 + k]].pos[axis];
+				}
+			}
+			beforeTriangles.push_back(a);
+			afterTriangles.push_back(b);
+		}
+		std::sort(beforeTriangles.begin(), beforeTriangles.end());
+		std::sort(afterTriangles.begin(), afterTriangles.end());
+
+		double ms = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+		//the reduced detail pass on the same model, with the settings reducePrimitive uses
+		std::vector<Vertex> reducedVertices;
+		std::vector<uint32_t> reducedIndices;
+		startTime = std::chrono::high_resolution_clock::now();
+		decimateMesh(vertices, indices, indices.size() / 6, 0.03f, &reducedVertices, &reducedIndices);
+		endTime = std::chrono::high_resolution_clock::now();
+		double reduceMs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+		std::cout << "mesh optimisation " << name << " " << indices.size() / 3 << " triangles " << vertices.size() << " vertices: acmr " << before.acmr << " -> " << after.acmr
+			<< ", atvr " << before.atvr << " -> " << after.atvr << ", overfetch " << before.overfetch << " -> " << after.overfetch
+			<< ", " << ms << " ms" << (beforeTriangles == afterTriangles ? "" : ", TRIANGLES CHANGED")
+			<< ", reduced to " << reducedIndices.size() / 3 << " triangles in " << reduceMs << " ms" << std::endl;
 	}
+}
 
-	static std::vector<char> readFile(const std::string& filename) {
-		std::ifstream file(filename, std::ios::ate | std::ios::binary);
+void benchmarkBatchTransforms() {
+#if defined(SIMD_AVX)
+	const char* kernels = "avx";
+#elif defined(SIMD_SSE)
+	const char* kernels = "sse";
+#else
+	const char* kernels = "scalar only";
+#endif
+	const size_t count = 1 << 20;
+	const int repeats = 20;
+	PositionStream positions;
+	positions.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		positions.x[i] = (float)(rand() % 1000);
+		positions.y[i] = (float)(rand() % 1000);
+		positions.z[i] = (float)(rand() % 1000);
+	}
+	PositionStream transformed;
+	glm::mat4 turn = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0, 1, 0));
+	auto rate = [&](std::function<void()> kernel) {
+		auto startTime = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++) {
+			kernel();
+		}
+		auto endTime = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000000.0;
+		return count * repeats / seconds / 1000000.0;
+	};
+	double translateBatch = rate([&]() { translatePositions(&positions, glm::vec3(1.0f)); });
+	double translateScalar = rate([&]() { translatePositionsScalar(&positions, glm::vec3(1.0f)); });
+	double transformBatch = rate([&]() { transformPositions(positions, &transformed, turn); });
+	double transformScalar = rate([&]() { transformPositionsScalar(positions, &transformed, turn); });
+	std::cout << "batch transforms (" << kernels << ") " << count << " vertices, million vertices/s batch vs scalar:" << std::endl;
+	std::cout << "  translate stream " << translateBatch << " vs " << translateScalar << ", transform stream " << transformBatch << " vs " << transformScalar
+		<< " (checksum " << transformed.x[count / 2] << ")" << std::endl;
+
+	//the paths the kernels are used in
+	BlockMesher mesher;
+	try {
+		mesher.loadPrimitives();
+	}
+	catch (const std::runtime_error& e) {
+		std::cout << "  meshing: skipped, models/ not found (" << e.what() << ")" << std::endl;
+		return;
+	}
+	Blocks blocks;
+	int size = (int)cbrt(100000 * 4.0);
+	while (blocks.getVectorSize() < 100000) {
+		blocks.addBlock(rand() % size, rand() % size, rand() % size, (blockType)(rand() % 5), (blockDirection)(rand() % 6));
+	}
+	std::vector<Vertex> meshVertices;
+	std::vector<uint32_t> meshIndices;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (auto& chunkEntry : blocks.chunks) {
+		meshVertices.clear();
+		meshIndices.clear();
+		mesher.meshChunk(*chunkEntry.second, &meshVertices, &meshIndices);
+	}
+	auto meshTime = std::chrono::high_resolution_clock::now();
+	BlockMesher loader;
+	loader.loadPrimitives();
+	auto loadTime = std::chrono::high_resolution_clock::now();
+	std::cout << "  meshing 100000 blocks " << std::chrono::duration_cast<std::chrono::microseconds>(meshTime - startTime).count() / 1000.0 << " ms, loading primitives " << std::chrono::duration_cast<std::chrono::microseconds>(loadTime - meshTime).count() / 1000.0 << " ms" << std::endl;
+}
 
-		if (!file.is_open()) {
-			throw std::runtime_error("failed to open file!");
+void benchmarkMemoryAllocator() {
+	//a 64 MB block like the device allocator uses, with buffer sized requests from 256 bytes to 1 MB at 256 byte alignment
+	//half the operations free a random live allocation, the other half allocate, so the block fills up and then churns
+	const VkDeviceSize blockSize = 64 * 1024 * 1024;
+	const int operations = 200000;
+	std::mt19937 random(7);
+	std::vector<VkDeviceSize> sizes(operations);
+	for (int i = 0; i < operations; i++) {
+		sizes[i] = (VkDeviceSize)(256 * pow(4096.0, std::uniform_real_distribution<double>(0, 1)(random)));
+	}
+	std::vector<int> choices(operations);
+	for (int i = 0; i < operations; i++) {
+		choices[i] = (int)(random() % 1000000);
+	}
+
+	TlsfAllocator tlsf(blockSize);
+	std::vector<std::pair<uint32_t, VkDeviceSize>> live;
+	size_t failures = 0;
+	size_t peakLive = 0;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < operations; i++) {
+		if (choices[i] % 2 == 0 && !live.empty()) {
+			size_t victim = choices[i] / 2 % live.size();
+			tlsf.free(live[victim].first);
+			live[victim] = live.back();
+			live.pop_back();
+			continue;
+		}
+		uint32_t handle;
+		VkDeviceSize offset;
+		if (tlsf.allocate(sizes[i], 256, &handle, &offset)) {
+			live.push_back(std::make_pair(handle, sizes[i]));
+			peakLive = std::max(peakLive, live.size());
+		}
+		else {
+			failures++;
+		}
+	}
+	auto tlsfTime = std::chrono::high_resolution_clock::now();
+	size_t freeRanges;
+	VkDeviceSize largestFree;
+	tlsf.getFreeRanges(&freeRanges, &largestFree);
+	VkDeviceSize freeSize = tlsf.getSize() - tlsf.getUsed();
+	double tlsfNs = std::chrono::duration_cast<std::chrono::nanoseconds>(tlsfTime - startTime).count() / (double)operations;
+	std::cout << "memory allocator " << operations << " operations on a 64 MB block: tlsf " << tlsfNs << " ns/op, " << live.size() << " live (peak " << peakLive << "), "
+		<< (100.0 * tlsf.getUsed() / tlsf.getSize()) << "% used, " << failures << " failed, " << freeRanges << " free ranges, fragmentation " << (100.0 * (freeSize - largestFree) / freeSize) << "%" << std::endl;
+
+	//the same requests through the first fit RangeAllocator the chunk pages use, in 256 byte units so the alignment comes for free
+	RangeAllocator firstFit((uint32_t)(blockSize / 256));
+	std::vector<std::pair<uint32_t, uint32_t>> firstFitLive;
+	size_t firstFitFailures = 0;
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < operations; i++) {
+		if (choices[i] % 2 == 0 && !firstFitLive.empty()) {
+			size_t victim = choices[i] / 2 % firstFitLive.size();
+			firstFit.free(firstFitLive[victim].first, firstFitLive[victim].second);
+			firstFitLive[victim] = firstFitLive.back();
+			firstFitLive.pop_back();
+			continue;
+		}
+		uint32_t units = (uint32_t)((sizes[i] + 255) / 256);
+		uint32_t offset;
+		if (firstFit.allocate(units, &offset)) {
+			firstFitLive.push_back(std::make_pair(offset, units));
+		}
+		else {
+			firstFitFailures++;
 		}
-		//determining size and allocating a buffer
-		size_t fileSize = (size_t)file.tellg();
-		std::vector<char> buffer(fileSize);
-		//reading the file
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		//closing file and returning the bytes
-		file.close();
-		return buffer;
 	}
+	auto firstFitTime = std::chrono::high_resolution_clock::now();
+	double firstFitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(firstFitTime - startTime).count() / (double)operations;
+	std::cout << "  first fit " << firstFitNs << " ns/op, " << firstFitLive.size() << " live, " << firstFitFailures << " failed, " << firstFit.getFreeRangeCount() << " free ranges"
+		<< ", the " << peakLive << " peak resources would have been " << peakLive << " vkAllocateMemory calls instead of 1" << std::endl;
+}
 
-	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objType, uint64_t obj, size_t location, int32_t code, const char* layerPrefix, const char* msg, void* userData) {
-		std::cerr << "validation layer: " << msg << std::endl;
+void runBenchmarks() {
+	benchmarkBlockRebuild();
+	benchmarkBlockMemory();
+	benchmarkBlockRemoval();
+	benchmarkRegionEdits();
+	benchmarkMortonOrder();
+	benchmarkSparseBackends();
+	benchmarkSnapshots();
+	benchmarkQueries();
+	benchmarkRemeshLatency();
+	benchmarkParallelMeshing();
+	benchmarkInstancing();
+	benchmarkWireMeshing();
+	benchmarkBoxMode();
+	benchmarkDetailLevels();
+	benchmarkPackedVertices();
+	benchmarkChunkIndices();
+	benchmarkMeshOptimisation();
+	benchmarkBatchTransforms();
+	benchmarkMemoryAllocator();
+}
 
-		return VK_FALSE;
+int main(int argc, char* argv[]) {
+	//"VulkanTest2.exe --benchmark" runs the CPU side benchmarks instead of opening the workspace
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+		runBenchmarks();
+		return EXIT_SUCCESS;
 	}
-};
 
-int main() {
 	WorkSpace app;
 	try {
 		app.run();
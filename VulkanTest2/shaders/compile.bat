@@ -1,3 +1,5 @@
 C:/VulkanSDK/1.0.33.0/Bin32/glslangValidator.exe -V shader.vert
 C:/VulkanSDK/1.0.33.0/Bin32/glslangValidator.exe -V shader.frag
+C:/VulkanSDK/1.0.33.0/Bin32/glslangValidator.exe -V instanced.vert -o instanced.spv
+C:/VulkanSDK/1.0.33.0/Bin32/glslangValidator.exe -V packed.vert -o packed.spv
 pause
\ No newline at end of file
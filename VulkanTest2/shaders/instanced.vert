@@ -0,0 +1,45 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+	float time;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+//per instance, one placed primitive
+layout(location = 3) in ivec3 inBlockPosition;
+layout(location = 4) in uint inOrientation;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out float time;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+//the rotations rotatePrimitive bakes into its PX, NX, PY, NY, PZ and NZ copies, columns first
+const mat3 orientations[6] = mat3[6](
+	mat3(1, 0, 0,  0, 1, 0,  0, 0, 1),
+	mat3(-1, 0, 0,  0, 1, 0,  0, 0, -1),
+	mat3(0, 1, 0,  -1, 0, 0,  0, 0, 1),
+	mat3(0, -1, 0,  1, 0, 0,  0, 0, 1),
+	mat3(0, 0, 1,  0, 1, 0,  -1, 0, 0),
+	mat3(0, 0, -1,  0, 1, 0,  1, 0, 0)
+);
+
+void main() {
+	//models are rotated about the centre of their block
+	vec3 position = orientations[inOrientation & 7u] * (inPosition - vec3(0.5)) + vec3(0.5) + vec3(inBlockPosition);
+	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(position, 1.0);
+
+    fragColor = inColor;
+	time = ubo.time;
+    fragTexCoord = inTexCoord;
+}
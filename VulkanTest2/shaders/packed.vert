@@ -0,0 +1,36 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+	float time;
+} ubo;
+
+//the chunk this mesh belongs to
+layout(push_constant) uniform ChunkConstants {
+	ivec4 origin;
+} chunk;
+
+//xyz is the position in 1024ths of a block from the chunk's corner, w holds the flags
+layout(location = 0) in ivec4 inPositionFlags;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out float time;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+void main() {
+	vec3 position = vec3(inPositionFlags.xyz) / 1024.0 + vec3(chunk.origin.xyz);
+	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(position, 1.0);
+
+    fragColor = inColor.rgb;
+	time = ubo.time;
+	//block geometry is never textured
+    fragTexCoord = vec2(0, 0);
+}